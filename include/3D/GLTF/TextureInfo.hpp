@@ -2,6 +2,8 @@
 #define FLOWER_EVOLVER_3D_GLTF_TEXTURE_INFO_HPP
 
 #include <string>
+#include <utility>
+#include <vector>
 #include <Image.hpp>
 
 namespace fe::gltf{
@@ -15,7 +17,7 @@ namespace fe::gltf{
          * @param tex_name The name of the texture.
          * @param base64_data_uri The full "data:image/png;base64,..." string.
          */
-        TextureInfo(const std::string& tex_name, const std::string& base64_data_uri);
+        TextureInfo(const std::string& tex_name, std::string base64_data_uri);
         /**
          * @brief Static helper to create fe::gltf::TextureInfo by processing an fe::Image.
          * @param tex_name The name of the texture.
@@ -23,6 +25,13 @@ namespace fe::gltf{
          * @return TextureInfo with the URI field populated.
          */
         static TextureInfo createFromImage(const std::string& tex_name, const fe::Image& raw_image);
+        /**
+         * @brief encodes several images at once, each one in a thread of fe::getThreadPool()
+         *        (up to RenderOptions::numThreads).
+         * @param images (name, image) of the textures.
+         * @return std::vector<TextureInfo> in the same order as images.
+         */
+        static std::vector<TextureInfo> createFromImages(const std::vector<std::pair<std::string, const fe::Image*>>& images);
         // data
         std::string name;
         std::string mimeType = "image/png";
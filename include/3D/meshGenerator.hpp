@@ -1,13 +1,59 @@
 #ifndef FLOWER_EVOLVER_3D_GEOMETRY_GENERATOR_HPP
 #define FLOWER_EVOLVER_3D_GEOMETRY_GENERATOR_HPP
 
+#include <Image.hpp>
 #include <3D/GLTF.hpp>
 #include <3D/FlowerParameters.hpp>
 
+#include <cstdint>
 #include <vector>
 #include <string>
 
 namespace fe{
+    namespace priv{
+        /**
+         * @brief options for generateNormalFromPetal.
+         */
+        struct NoiseOptions{
+            // Number of random noise points to add.
+            unsigned int numPoints{32};
+            // Minimum noise intensity (can be negative for darkening).
+            int noiseMin{-14};
+            // Maximum noise intensity
+            int noiseMax{64};
+            // Should we blend noise over a region?
+            bool softNoise{true};
+            // Radius for soft noise (in pixels) around the chosen point.
+            unsigned int spread{6};
+            // Controls how quickly the noise intensity falls off.
+            float softnessFactor{1.1};
+            // Favor stretching noise horizontally
+            float directionBiasX{0.2};
+            // Favor stretching vertically
+            float directionBiasY{0.5};
+            // Global noise multiplier
+            float scaleStrength{0.5};
+            // Frequency of variation in procedural noise
+            float frequency{0.9};
+            // Adds extra random offset to each point
+            float jitter{0.4};
+            // Controls intensity ramp (e.g. for sharpening/blooming)
+            float noisePower{0.8};
+            // Base level without noise
+            float baseHeight{0.6};
+            // Every pixel draws its noise from the stream (seed, y * width + x)
+            std::uint64_t seed{0};
+        };
+        /**
+         * @brief generates a noisy normal map for the opaque pixels of a petal layer texture.
+         *        the rows are split between the threads of fe::getThreadPool(), the noise of each
+         *        pixel comes from its own stream so the result only depends on options.seed.
+         * @param sourceImage const fe::Image& petal layer texture.
+         * @param options const NoiseOptions& noise options.
+         * @return fe::Image normal map with the same size as sourceImage.
+         */
+        fe::Image generateNormalFromPetal(const fe::Image& sourceImage, const NoiseOptions& options);
+    } // namespace priv
     /**
      * @brief Generates a single segment of a cylinder with potentially elliptical and tapered cross-sections.
      * @details Creates the wall and optionally top/bottom caps.
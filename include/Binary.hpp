@@ -0,0 +1,66 @@
+#ifndef FLOWER_EVOLVER_BINARY_HPP
+#define FLOWER_EVOLVER_BINARY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <JsonBox.h>
+
+namespace fe{
+	/**
+	 *  @brief compact binary encoding of the json documents (Flower.json, DNA, Genome).
+	 *
+	 *  It is lossless: decode(encode(v)) writes the same json as v.
+	 *  @code
+	 *      "FEB" version:u8
+	 *      numKeys:varint (length:varint bytes)*    object keys sorted, written once
+	 *      value
+	 *  @endcode
+	 *  A value is a Tag byte followed by:
+	 *      Integer zigzag varint, Float little endian float32 (doubles that are exact as float),
+	 *      Double little endian float64, String length:varint bytes, Array count:varint values,
+	 *      Object count:varint (key index:varint value)*.
+	 */
+	namespace binary{
+		/// version written after the magic, decode rejects newer ones.
+		constexpr std::uint8_t version = 1;
+		/**
+		 *  @brief type of the next value.
+		 */
+		enum class Tag : std::uint8_t{
+			Null,
+			False,
+			True,
+			Integer,
+			Float,
+			Double,
+			String,
+			Array,
+			Object
+		};
+		/**
+		 *  @brief encodes a json value.
+		 *  @param [in] v const JsonBox::Value&
+		 *  @return std::vector<std::uint8_t>
+		 */
+		std::vector<std::uint8_t> encode(const JsonBox::Value& v);
+		/**
+		 *  @brief decodes a value written by encode.
+		 *  @param [in] data const std::uint8_t*
+		 *  @param [in] size std::size_t
+		 *  @throw std::invalid_argument if it is not valid, truncated or from a newer version.
+		 *  @return JsonBox::Value
+		 */
+		JsonBox::Value decode(const std::uint8_t* data, std::size_t size);
+		/**
+		 *  @brief checks the magic, it doesn't validate the rest.
+		 *  @param [in] data const std::uint8_t*
+		 *  @param [in] size std::size_t
+		 *  @return bool
+		 */
+		bool isBinary(const std::uint8_t* data, std::size_t size) noexcept;
+	} // namespace binary
+} // namespace fe
+
+#endif // FLOWER_EVOLVER_BINARY_HPP
@@ -0,0 +1,230 @@
+#ifndef FLOWER_EVOLVER_CPPN_HPP
+#define FLOWER_EVOLVER_CPPN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <EvoAI.hpp>
+
+namespace fe{
+	/**
+	 *  @brief a CPPN genome compiled into a flat tape of instructions.
+	 *
+	 *  The phenotype is sorted by layer, every non input node becomes an instruction
+	 *  with its bias, activation and weighted inputs, so an evaluation is a single
+	 *  pass over contiguous arrays into caller provided buffers without heap allocations.
+	 *  It uses double like EvoAI so the results are the same, the inputs get squared and
+	 *  go through sin / cos and float loses too much precision for large radii.
+	 *  If the phenotype has something the tape can't represent (context neurons,
+	 *  unsupported activations) or the tape doesn't match EvoAI::NeuralNetwork::forward
+	 *  on a few probe inputs, it falls back to the EvoAI::NeuralNetwork.
+	 *  @code
+	 *      fe::CPPN cppn(genome);
+	 *      double in[4] = {radius, angle, layer, bias};
+	 *      double out[4];
+	 *      cppn.forward(in, out);
+	 *  @endcode
+	 */
+	class CPPN final{
+		public:
+			/**
+			 *  @brief activations the tape can evaluate.
+			 */
+			enum class Activation : std::uint8_t{
+				Identity,
+				Sigmoid,
+				SteepenedSigmoid,
+				Swish,
+				Tanh,
+				Sinusoid,
+				Cosine,
+				Tan,
+				Relu,
+				Gaussian,
+				Square,
+				Cube,
+				Softplus,
+				Clamp,
+				Abs,
+				Exp,
+				Hat
+			};
+			/**
+			 *  @brief computes values[node] = activation(bias + sum(inputs))
+			 */
+			struct Instruction final{
+				/// index in values
+				std::uint32_t node;
+				/// first Input in the inputs array
+				std::uint32_t firstInput;
+				std::uint32_t numInputs;
+				double bias;
+				Activation activation;
+			};
+			/**
+			 *  @brief a weighted input of an Instruction.
+			 */
+			struct Input final{
+				/// index in values
+				std::uint32_t node;
+				double weight;
+			};
+			/// number of lanes evaluateBatch processes at once.
+			static constexpr std::size_t batchSize = 64;
+		public:
+			/**
+			 *  @brief compiles the genome, it falls back to its phenotype if it can't.
+			 *  @param [in] g const EvoAI::Genome& a cppn
+			 */
+			explicit CPPN(const EvoAI::Genome& g) noexcept;
+			/**
+			 *  @brief is it using the tape (true) or the EvoAI::NeuralNetwork (false)
+			 *  @return bool
+			 */
+			bool isCompiled() const noexcept;
+			/**
+			 *  @brief number of inputs.
+			 *  @return std::size_t
+			 */
+			std::size_t getNumInputs() const noexcept;
+			/**
+			 *  @brief number of outputs.
+			 *  @return std::size_t
+			 */
+			std::size_t getNumOutputs() const noexcept;
+			/**
+			 *  @brief size of the values buffer evaluate needs.
+			 *  @return std::size_t
+			 */
+			std::size_t getNumNodes() const noexcept;
+			/**
+			 *  @brief runs the tape, it needs isCompiled() to be true.
+			 *
+			 *  It doesn't modify the CPPN so many threads can use it with their own buffers.
+			 *  @param [in] inputs   const double* getNumInputs() values
+			 *  @param [out] outputs double* getNumOutputs() values
+			 *  @param [in,out] values double* getNumNodes() scratch values
+			 */
+			void evaluate(const double* inputs, double* outputs, double* values) const noexcept;
+			/**
+			 *  @brief runs the tape for up to batchSize inputs in SoA layout, it needs isCompiled() to be true.
+			 *
+			 *  Every instruction is applied to all the lanes before the next one, the weighted sums
+			 *  and the piecewise linear activations use wasm simd128 when it is enabled (FE_SIMD),
+			 *  the rest is applied per lane, the results are the same as evaluate.
+			 *  @param [in] inputs   const double* const* getNumInputs() arrays of count values
+			 *  @param [out] outputs double* const* getNumOutputs() arrays of count values
+			 *  @param [in] count    std::size_t [0, batchSize]
+			 *  @param [in,out] values double* getNumNodes() * batchSize scratch values
+			 */
+			void evaluateBatch(const double* const* inputs, double* const* outputs, std::size_t count, double* values) const noexcept;
+			/**
+			 *  @brief runs the tape or the EvoAI::NeuralNetwork if it is not compiled for count inputs in SoA layout.
+			 *
+			 *  The scratch values are thread_local so threads can share the CPPN, the
+			 *  EvoAI::NeuralNetwork keeps its values in the neurons so it is used by one thread at a time.
+			 *  @param [in] inputs   const double* const* getNumInputs() arrays of count values
+			 *  @param [out] outputs double* const* getNumOutputs() arrays of count values
+			 *  @param [in] count    std::size_t
+			 */
+			void forwardBatch(const double* const* inputs, double* const* outputs, std::size_t count) const noexcept;
+			/**
+			 *  @brief runs the tape or the EvoAI::NeuralNetwork if it is not compiled, threads can share the CPPN like forwardBatch.
+			 *  @param [in] inputs   const double* getNumInputs() values
+			 *  @param [out] outputs double* getNumOutputs() values
+			 */
+			void forward(const double* inputs, double* outputs) const noexcept;
+			/**
+			 *  @brief the instructions in evaluation order.
+			 *  @return const std::vector<Instruction>&
+			 */
+			const std::vector<Instruction>& getTape() const noexcept;
+			/**
+			 *  @brief the weighted inputs of the instructions.
+			 *  @return const std::vector<Input>&
+			 */
+			const std::vector<Input>& getInputs() const noexcept;
+			/**
+			 *  @brief index in values of each output.
+			 *  @return const std::vector<std::uint32_t>&
+			 */
+			const std::vector<std::uint32_t>& getOutputs() const noexcept;
+			/**
+			 *  @brief memory used by the tape and its buffers (or the EvoAI::NeuralNetwork).
+			 *  @return std::size_t bytes
+			 */
+			std::size_t getSizeInBytes() const noexcept;
+		private:
+			bool compile(EvoAI::NeuralNetwork& nn) noexcept;
+			bool matches(EvoAI::NeuralNetwork& nn) noexcept;
+		private:
+			std::vector<Instruction> m_tape;
+			std::vector<Input> m_inputs;
+			std::vector<std::uint32_t> m_outputs;
+			std::size_t m_numNodes;
+			std::size_t m_numInputs;
+			std::size_t m_numOutputs;
+			/// fallback when it can't be compiled, forward writes the values of its neurons.
+			mutable std::optional<EvoAI::NeuralNetwork> m_nn;
+			mutable std::mutex m_nnMutex;
+			/// estimated from the genome, 0 if compiled
+			std::size_t m_phenotypeBytes;
+	};
+	/**
+	 *  @brief gets the CPPN of the genome from the cache or compiles it.
+	 *  
+	 *  The cache is keyed by hashGenome (exact weights) and shared by every call (drawFlower, make3DFlower,
+	 *  drawLayer, stats, ...), CPPNs are kept while they fit in the cache limit and get
+	 *  evicted least recently used first. The cached CPPN is immutable, many threads can
+	 *  draw the same genome at once.
+	 *  @code
+	 *      auto nn = fe::getCPPN(genome);
+	 *      nn->forward(in, out);
+	 *  @endcode
+	 *  @param [in] g const EvoAI::Genome& a cppn
+	 *  @return std::shared_ptr<const CPPN>
+	 */
+	std::shared_ptr<const CPPN> getCPPN(const EvoAI::Genome& g) noexcept;
+	/**
+	 *  @brief sets the memory limit of the CPPN cache (1/32 of the wasm heap or 4 MB natively by default).
+	 *  @param [in] bytes std::size_t 0 disables the cache
+	 */
+	void setCPPNCacheLimit(std::size_t bytes) noexcept;
+	/**
+	 *  @brief removes all the cached CPPN.
+	 */
+	void clearCPPNCache() noexcept;
+	namespace priv{
+		/**
+		 *  @brief maps an EvoAI activation to the tape activation.
+		 *
+		 *  @param [in] type EvoAI::Neuron::ActivationType
+		 *  @param [out] act CPPN::Activation
+		 *  @return bool false if the tape doesn't support it.
+		 */
+		bool toTapeActivation(EvoAI::Neuron::ActivationType type, CPPN::Activation& act) noexcept;
+		/**
+		 *  @brief applies the activation.
+		 *
+		 *  @param [in] act CPPN::Activation
+		 *  @param [in] x double
+		 *  @return double
+		 */
+		double activate(CPPN::Activation act, double x) noexcept;
+		/**
+		 *  @brief values[i] = activate(act, values[i] + bias) for count values.
+		 *
+		 *  @param [in] act CPPN::Activation
+		 *  @param [in,out] values double*
+		 *  @param [in] bias double
+		 *  @param [in] count std::size_t
+		 */
+		void activateBatch(CPPN::Activation act, double* values, double bias, std::size_t count) noexcept;
+	} // namespace priv
+} // namespace fe
+
+#endif // FLOWER_EVOLVER_CPPN_HPP
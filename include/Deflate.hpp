@@ -0,0 +1,54 @@
+#ifndef FLOWER_EVOLVER_DEFLATE_HPP
+#define FLOWER_EVOLVER_DEFLATE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace fe{
+	/**
+	 *  @brief zlib (RFC 1950) / deflate (RFC 1951) compressor for the png encoder.
+	 *
+	 *  LZ77 with hash chains, greedy matching for levels 1-3 (fast) and lazy matching for 4-9,
+	 *  level 0 stores the data. Every block is written stored, with the fixed or with dynamic
+	 *  huffman codes, whatever is smaller, so the output is never bigger than zlibBound.
+	 *  @code
+	 *      std::vector<std::uint8_t> out(fe::deflate::zlibBound(size));
+	 *      out.resize(fe::deflate::zlib(data, size, 6, out.data()));
+	 *  @endcode
+	 */
+	namespace deflate{
+		/**
+		 *  @brief largest zlib stream zlib can write for size bytes (stored blocks).
+		 *  @param [in] size std::size_t
+		 *  @return std::size_t
+		 */
+		std::size_t zlibBound(std::size_t size) noexcept;
+		/**
+		 *  @brief compresses data as a zlib stream.
+		 *  @param [in]  data  const std::uint8_t*
+		 *  @param [in]  size  std::size_t
+		 *  @param [in]  level int [0, 9], 0 stores, 1 is the fastest and 9 the smallest
+		 *  @param [out] out   std::uint8_t* at least zlibBound(size) bytes
+		 *  @return std::size_t bytes written to out
+		 */
+		std::size_t zlib(const std::uint8_t* data, std::size_t size, int level, std::uint8_t* out) noexcept;
+		/**
+		 *  @brief crc32 of the png chunks, crc32(b, crc32(a)) is the crc32 of a and b.
+		 *  @param [in] data const std::uint8_t*
+		 *  @param [in] size std::size_t
+		 *  @param [in] crc  std::uint32_t crc of the previous data
+		 *  @return std::uint32_t
+		 */
+		std::uint32_t crc32(const std::uint8_t* data, std::size_t size, std::uint32_t crc = 0) noexcept;
+		/**
+		 *  @brief adler32 checksum of the zlib streams.
+		 *  @param [in] data  const std::uint8_t*
+		 *  @param [in] size  std::size_t
+		 *  @param [in] adler std::uint32_t checksum of the previous data
+		 *  @return std::uint32_t
+		 */
+		std::uint32_t adler32(const std::uint8_t* data, std::size_t size, std::uint32_t adler = 1) noexcept;
+	} // namespace deflate
+} // namespace fe
+
+#endif // FLOWER_EVOLVER_DEFLATE_HPP
@@ -1,9 +1,11 @@
 #ifndef FLOWER_EVOLVER_HPP
 #define FLOWER_EVOLVER_HPP
 
+#ifdef __EMSCRIPTEN__
 #include <emscripten/val.h>
 #include <emscripten/bind.h>
 #include <emscripten.h>
+#endif
 
 #include <sstream>
 #include <chrono>
@@ -13,16 +15,20 @@
 
 #include <Flower.hpp>
 #include <Stats.hpp>
+#include <Platform.hpp>
+#include <Profile.hpp>
+#include <Trace.hpp>
+#include <RenderOptions.hpp>
+#include <GenomeHash.hpp>
+#include <Random.hpp>
+#include <GenomeRegistry.hpp>
+#include <Binary.hpp>
+#include <JsonReader.hpp>
 
+#ifdef __EMSCRIPTEN__
 /// global document access
 thread_local const emscripten::val document = emscripten::val::global("document");
-/**
- * @brief it will copy the ptr buffer into the canvas with id "canvas"
- * @param ptr std::uint8_t* buffer to copy to canvas
- * @param w int width for the canvas
- * @param h int height for the canvas
- */
-void copyToCanvas(std::uint8_t* ptr, int w, int h);
+#endif
 /**
  * @brief make flower, it will paint into the canvas, is up to you to get the image from it.
  * 
@@ -153,6 +159,309 @@ std::string mutate(const std::string& original, int radius, int numLayers, float
  * @return std::string json for stats.
  */
 std::string getFlowerStats(const std::string& genome, float humidity, int temperature, int altitude, int terrainType);
+/**
+ * @brief gets the memory usage of the module.
+ * @return std::string json {"heapSize", "footprint", "maxFootprint", "inUse"} in bytes,
+ *         maxFootprint is only sampled at each call in native builds.
+ */
+std::string getHeapStats() noexcept;
+/**
+ * @brief gets the profiling counters and timers, build with -DFE_PROFILE=TRUE to enable them.
+ * @return std::string json {"enabled", "timers": {name: {"calls", "ms"}}, "counters": {name: n}}
+ */
+std::string getProfile() noexcept;
+/**
+ * @brief resets the profiling counters and timers.
+ */
+void resetProfile() noexcept;
+/**
+ * @brief enables or disables recording trace spans (disabled by default).
+ * @param enabled bool
+ */
+void setTraceEnabled(bool enabled) noexcept;
+/**
+ * @brief gets the recorded spans as chrome trace event json, it can be opened with Perfetto or chrome://tracing
+ * @return std::string json {"traceEvents": [...]}
+ */
+std::string getTrace() noexcept;
+/**
+ * @brief removes the recorded spans.
+ */
+void clearTrace() noexcept;
+/**
+ * @brief sets the options of the petals renderer (fe::RenderOptions), missing keys get the default values.
+ * @param options const std::string& json {"periodTolerance": float [0, 1e-4], "sampleTolerance": float [0, 1]} 0 is exact,
+ *        {"numThreads": int >= 0} threads that render a layer, 0 uses the whole pool and 1 the calling thread.
+ * @throw std::invalid_argument if a value is out of range.
+ */
+void setRenderOptions(const std::string& options);
+/**
+ * @brief gets the options of the petals renderer.
+ * @return std::string json fe::RenderOptions
+ */
+std::string getRenderOptions() noexcept;
+/**
+ * @brief sets the memory limit of the compiled genomes cache shared by every call (640 KB of the 20 MB heap by default).
+ * @param bytes int 0 disables the cache
+ */
+void setCPPNCacheLimit(int bytes) noexcept;
+/**
+ * @brief removes the compiled genomes from the cache.
+ */
+void clearCPPNCache() noexcept;
+/**
+ * @brief every call uses this seed until clearSeed, the same calls with the same seed and inputs
+ *        give the same genomes, canvas pixels and glTF (deterministic mode).
+ * @param seed double integer in [0, 2^53]
+ * @throw std::invalid_argument if seed is not an integer in range.
+ */
+void setSeed(double seed);
+/**
+ * @brief every call takes a new seed from the clock (default).
+ */
+void clearSeed() noexcept;
+/**
+ * @brief structural hash of the flower DNA (fe::hashDNA), flowers with the same genes hash equal.
+ * @param genome const std::string& stringified flower.json
+ * @param precision double weights and biases are rounded to multiples of it, 0 is exact.
+ * @return std::string 128 bits hash as 32 hex characters.
+ * @throw std::invalid_argument if the flower can't be parsed or precision < 0.
+ */
+std::string hashFlower(const std::string& genome, double precision);
+/**
+ * @brief parses a flower once and keeps it (with its compiled genome) for the *ByHandle functions.
+ * 
+ * Loaded genomes are kept until releaseGenome or until they are the least recently used
+ * when more than setGenomeLimit are loaded.
+ * @param flower const std::string& stringified Flower.json
+ * @return int handle > 0, handles are not reused.
+ * @throw std::invalid_argument if the flower can't be parsed or the genome limit is 0.
+ */
+int loadGenome(const std::string& flower);
+/**
+ * @brief releases a genome loaded with loadGenome.
+ * @param handle int
+ * @return bool false if the handle was unknown, released or evicted.
+ */
+bool releaseGenome(int handle) noexcept;
+/**
+ * @brief sets how many genomes can be loaded at the same time (256 by default).
+ * @param maxGenomes int the least recently used ones are evicted, 0 disables loading (loadGenome throws).
+ */
+void setGenomeLimit(int maxGenomes) noexcept;
+/**
+ * @brief releases all the loaded genomes.
+ */
+void clearGenomes() noexcept;
+/**
+ * @brief drawFlower with a loaded genome.
+ * 
+ * @param handle int from loadGenome
+ * @param radius int radius for the flower
+ * @param numLayers int how many layers it will have
+ * @param P float P parameter it controls how many petals the flower can have.
+ * @param bias float bias
+ * @throw std::invalid_argument if the handle is unknown.
+ */
+void drawFlowerByHandle(int handle, int radius, int numLayers, float P, float bias);
+/**
+ * @brief drawPetals with a loaded genome.
+ * 
+ * @param handle int from loadGenome
+ * @param radius int radius for the flower
+ * @param numLayers int how many layers it will have
+ * @param P float P parameter it controls how many petals the flower can have.
+ * @param bias float bias
+ * @throw std::invalid_argument if the handle is unknown.
+ */
+void drawPetalsByHandle(int handle, int radius, int numLayers, float P, float bias);
+/**
+ * @brief drawPetalLayer with a loaded genome.
+ * 
+ * @param handle int from loadGenome
+ * @param radius int radius for the flower
+ * @param numLayers int how many layers it will have
+ * @param P float P parameter it controls how many petals the flower can have.
+ * @param bias float bias
+ * @param layer int layer to paint
+ * @throw std::invalid_argument if the handle is unknown.
+ */
+void drawPetalLayerByHandle(int handle, int radius, int numLayers, float P, float bias, int layer);
+/**
+ * @brief reproduce with loaded genomes.
+ * 
+ * @param handle1 int from loadGenome
+ * @param handle2 int from loadGenome
+ * @param radius int radius for the flower
+ * @param numLayers int how many layers it will have
+ * @param P float P parameter it controls how many petals the flower can have.
+ * @param bias float bias
+ * @return it will return a stringified Flower.json, load it to use it as a handle.
+ * @throw std::invalid_argument if a handle is unknown.
+ */
+std::string reproduceByHandle(int handle1, int handle2, int radius, int numLayers, float P, float bias);
+/**
+ * @brief mutate with a loaded genome, the loaded genome is not modified.
+ * 
+ * @param handle int from loadGenome
+ * @param radius int radius for the flower
+ * @param numLayers int how many layers it will have
+ * @param P float P parameter it controls how many petals the flower can have.
+ * @param bias float bias
+ * @param addNodeRate float rate to determine what it mutates
+ * @param addConnRate float rate to determine what it mutates
+ * @param removeConnRate float rate to determine what it mutates
+ * @param perturbWeightsRate float rate to determine what it mutates
+ * @param enableRate float rate to determine what it mutates
+ * @param disableRate float rate to determine what it mutates
+ * @param actTypeRate float rate to determine what it mutates
+ * @return it will return a stringified Flower.json, load it to use it as a handle.
+ * @throw std::invalid_argument if the handle is unknown.
+ */
+std::string mutateByHandle(int handle, int radius, int numLayers, float P, float bias, 
+					float addNodeRate, float addConnRate, float removeConnRate, float perturbWeightsRate, 
+					float enableRate, float disableRate, float actTypeRate);
+/**
+ * @brief getFlowerStats with a loaded genome.
+ * @param handle int from loadGenome
+ * @param humidity float 0.0 to 1.0
+ * @param temperature int temperature
+ * @param altitude int meters above sea
+ * @param terrainType int terrain type
+ * @return std::string json for stats.
+ * @throw std::invalid_argument if the handle is unknown.
+ */
+std::string getFlowerStatsByHandle(int handle, float humidity, int temperature, int altitude, int terrainType);
+/**
+ * @brief hashFlower with a loaded genome.
+ * @param handle int from loadGenome
+ * @param precision double weights and biases are rounded to multiples of it, 0 is exact.
+ * @return std::string 128 bits hash as 32 hex characters.
+ * @throw std::invalid_argument if the handle is unknown or precision < 0.
+ */
+std::string hashFlowerByHandle(int handle, double precision);
+/**
+ * @brief make3DFlower with a loaded genome.
+ * @param handle int from loadGenome
+ * @param radius Initial radius parameter for fe::Petals constructor.
+ * @param numLayers Number of layers parameter for fe::Petals constructor and loop control.
+ * @param P P parameter for fe::Petals constructor.
+ * @param bias Bias parameter for fe::Petals constructor.
+ * @param flowerId A unique string identifier for this flower instance (used in group names).
+ * @param flowerParams std::string json fe::FlowerParameters for the 3d flower.
+ * @return A std::string containing the 3D model in GLTF format.
+ * @throw std::invalid_argument if the handle is unknown.
+ */
+std::string make3DFlowerByHandle(int handle, int radius, int numLayers, float P, float bias, const std::string& flowerId, const std::string& flowerParams = "");
+/**
+ * @brief decodes a binary flower (fe::binary) into a stringified Flower.json.
+ * @param data const std::string& Uint8Array from flowerToBinary
+ * @return std::string the same json that was encoded.
+ * @throw std::invalid_argument if data is not a valid binary flower.
+ */
+std::string binaryToFlower(const std::string& data);
+/**
+ * @brief loadGenome from a binary flower, it doesn't parse any json.
+ * @param data const std::string& Uint8Array from flowerToBinary
+ * @return int handle > 0
+ * @throw std::invalid_argument if data is not a valid binary flower or the genome limit is 0.
+ */
+int loadGenomeBinary(const std::string& data);
+
+#ifdef __EMSCRIPTEN__
+/**
+ * @brief encodes a flower in the compact binary format (fe::binary), it is lossless and several times smaller than the json.
+ * @param flower const std::string& stringified Flower.json
+ * @return Uint8Array
+ * @throw std::invalid_argument if the flower can't be parsed.
+ */
+emscripten::val flowerToBinary(const std::string& flower);
+/**
+ * @brief renders the flower without touching any canvas (headless, workers or node).
+ * 
+ * The pixels are a view of the wasm memory, it is valid until the next render*RGBA call
+ * or until the memory grows, copy it (data.slice()) to keep it.
+ * @param flower const std::string& stringified Flower.json
+ * @param radius int radius for the flower
+ * @param numLayers int how many layers it will have
+ * @param P float P parameter it controls how many petals the flower can have.
+ * @param bias float bias
+ * @return {width, height, data: Uint8Array rgba}
+ * @throw std::invalid_argument if the flower can't be parsed.
+ */
+emscripten::val renderFlowerRGBA(const std::string& flower, int radius, int numLayers, float P, float bias);
+/**
+ * @brief renders the flower petals (no stem) without touching any canvas, see renderFlowerRGBA.
+ * 
+ * @param flower const std::string& stringified Flower.json
+ * @param radius int radius for the flower
+ * @param numLayers int how many layers it will have
+ * @param P float P parameter it controls how many petals the flower can have.
+ * @param bias float bias
+ * @return {width, height, data: Uint8Array rgba}
+ * @throw std::invalid_argument if the flower can't be parsed.
+ */
+emscripten::val renderPetalsRGBA(const std::string& flower, int radius, int numLayers, float P, float bias);
+/**
+ * @brief renders a petal layer (no stem) without touching any canvas, see renderFlowerRGBA.
+ * 
+ * @param flower const std::string& stringified Flower.json
+ * @param radius int radius for the flower
+ * @param numLayers int how many layers it will have
+ * @param P float P parameter it controls how many petals the flower can have.
+ * @param bias float bias
+ * @param layer int layer to render
+ * @return {width, height, data: Uint8Array rgba}
+ * @throw std::invalid_argument if the flower can't be parsed.
+ */
+emscripten::val renderPetalLayerRGBA(const std::string& flower, int radius, int numLayers, float P, float bias, int layer);
+/**
+ * @brief renderFlowerRGBA with a loaded genome.
+ * 
+ * @param handle int from loadGenome
+ * @param radius int radius for the flower
+ * @param numLayers int how many layers it will have
+ * @param P float P parameter it controls how many petals the flower can have.
+ * @param bias float bias
+ * @return {width, height, data: Uint8Array rgba}
+ * @throw std::invalid_argument if the handle is unknown.
+ */
+emscripten::val renderFlowerRGBAByHandle(int handle, int radius, int numLayers, float P, float bias);
+/**
+ * @brief renderPetalsRGBA with a loaded genome.
+ * 
+ * @param handle int from loadGenome
+ * @param radius int radius for the flower
+ * @param numLayers int how many layers it will have
+ * @param P float P parameter it controls how many petals the flower can have.
+ * @param bias float bias
+ * @return {width, height, data: Uint8Array rgba}
+ * @throw std::invalid_argument if the handle is unknown.
+ */
+emscripten::val renderPetalsRGBAByHandle(int handle, int radius, int numLayers, float P, float bias);
+/**
+ * @brief renderPetalLayerRGBA with a loaded genome.
+ * 
+ * @param handle int from loadGenome
+ * @param radius int radius for the flower
+ * @param numLayers int how many layers it will have
+ * @param P float P parameter it controls how many petals the flower can have.
+ * @param bias float bias
+ * @param layer int layer to render
+ * @return {width, height, data: Uint8Array rgba}
+ * @throw std::invalid_argument if the handle is unknown.
+ */
+emscripten::val renderPetalLayerRGBAByHandle(int handle, int radius, int numLayers, float P, float bias, int layer);
+/**
+ * @brief encodes the last flower drawn or rendered by any draw*, make*, reproduce*, mutate* or render*RGBA call.
+ * 
+ * @param format const std::string& "png" or "qoi" (lossless, faster to encode than png)
+ * @param effort int png compression level 0-9, higher is smaller but slower (ignored by qoi)
+ * @param filter int png row filter 0-4 or -1 to choose it (ignored by qoi)
+ * @return Uint8Array encoded image
+ * @throw std::invalid_argument if nothing was drawn or the format is unknown.
+ */
+emscripten::val encodeFlower(const std::string& format, int effort, int filter);
 /**
  * @brief gets the exception message
  * @param exceptionPtr std::exception*
@@ -192,7 +501,65 @@ EMSCRIPTEN_BINDINGS(mutate){
 EMSCRIPTEN_BINDINGS(){
     emscripten::function("getFlowerStats", &getFlowerStats);
 }
+EMSCRIPTEN_BINDINGS(getHeapStats){
+    emscripten::function("getHeapStats", &getHeapStats);
+}
+EMSCRIPTEN_BINDINGS(getProfile){
+    emscripten::function("getProfile", &getProfile);
+    emscripten::function("resetProfile", &resetProfile);
+}
+EMSCRIPTEN_BINDINGS(getTrace){
+    emscripten::function("setTraceEnabled", &setTraceEnabled);
+    emscripten::function("getTrace", &getTrace);
+    emscripten::function("clearTrace", &clearTrace);
+}
+EMSCRIPTEN_BINDINGS(renderOptions){
+    emscripten::function("setRenderOptions", &setRenderOptions);
+    emscripten::function("getRenderOptions", &getRenderOptions);
+}
+EMSCRIPTEN_BINDINGS(cppnCache){
+    emscripten::function("setCPPNCacheLimit", &setCPPNCacheLimit);
+    emscripten::function("clearCPPNCache", &clearCPPNCache);
+}
+EMSCRIPTEN_BINDINGS(seed){
+    emscripten::function("setSeed", &setSeed);
+    emscripten::function("clearSeed", &clearSeed);
+}
+EMSCRIPTEN_BINDINGS(hashFlower){
+    emscripten::function("hashFlower", &hashFlower);
+}
+EMSCRIPTEN_BINDINGS(genomeRegistry){
+    emscripten::function("loadGenome", &loadGenome);
+    emscripten::function("releaseGenome", &releaseGenome);
+    emscripten::function("setGenomeLimit", &setGenomeLimit);
+    emscripten::function("clearGenomes", &clearGenomes);
+    emscripten::function("drawFlowerByHandle", &drawFlowerByHandle);
+    emscripten::function("drawPetalsByHandle", &drawPetalsByHandle);
+    emscripten::function("drawPetalLayerByHandle", &drawPetalLayerByHandle);
+    emscripten::function("reproduceByHandle", &reproduceByHandle);
+    emscripten::function("mutateByHandle", &mutateByHandle);
+    emscripten::function("getFlowerStatsByHandle", &getFlowerStatsByHandle);
+    emscripten::function("hashFlowerByHandle", &hashFlowerByHandle);
+    emscripten::function("make3DFlowerByHandle", &make3DFlowerByHandle);
+}
+EMSCRIPTEN_BINDINGS(binary){
+    emscripten::function("flowerToBinary", &flowerToBinary);
+    emscripten::function("binaryToFlower", &binaryToFlower);
+    emscripten::function("loadGenomeBinary", &loadGenomeBinary);
+}
+EMSCRIPTEN_BINDINGS(renderRGBA){
+    emscripten::function("renderFlowerRGBA", &renderFlowerRGBA);
+    emscripten::function("renderPetalsRGBA", &renderPetalsRGBA);
+    emscripten::function("renderPetalLayerRGBA", &renderPetalLayerRGBA);
+    emscripten::function("renderFlowerRGBAByHandle", &renderFlowerRGBAByHandle);
+    emscripten::function("renderPetalsRGBAByHandle", &renderPetalsRGBAByHandle);
+    emscripten::function("renderPetalLayerRGBAByHandle", &renderPetalLayerRGBAByHandle);
+}
+EMSCRIPTEN_BINDINGS(encodeFlower){
+    emscripten::function("encodeFlower", &encodeFlower);
+}
 EMSCRIPTEN_BINDINGS(getExceptionMessage) {
     emscripten::function("getExceptionMessage", &getExceptionMessage);
 };
+#endif // __EMSCRIPTEN__
 #endif // FLOWER_EVOLVER_HPP
@@ -0,0 +1,56 @@
+#ifndef FLOWER_EVOLVER_GENOME_HASH_HPP
+#define FLOWER_EVOLVER_GENOME_HASH_HPP
+
+#include <cstdint>
+#include <string>
+
+#include <DNA.hpp>
+
+#include <EvoAI.hpp>
+
+namespace fe{
+	/**
+	 *  @brief 128 bits structural hash of a genome or a DNA.
+	 *  @code
+	 *      auto h = fe::hashDNA(dna);
+	 *      if(h == fe::hashDNA(other)){
+	 *          // same flower within the precision
+	 *      }
+	 *      auto key = h.low; // 64 bits key
+	 *  @endcode
+	 */
+	struct GenomeHash final{
+		std::uint64_t high{0};
+		std::uint64_t low{0};
+		/**
+		 *  @brief 32 hex characters, high first.
+		 *  @return std::string
+		 */
+		std::string toString() const noexcept;
+		bool operator==(const GenomeHash& rhs) const noexcept;
+		bool operator!=(const GenomeHash& rhs) const noexcept;
+	};
+	/// weights and biases are rounded to multiples of this by default.
+	constexpr double defaultHashPrecision = 1e-6;
+	/**
+	 *  @brief structural hash of a genome.
+	 *
+	 *  It hashes the canonical form of the genome: nodes (layer, id, type, activation, bias) sorted by
+	 *  (layer, id) and enabled connections (source, destination, weight) sorted by (source, destination, weight),
+	 *  so genomes with the same genes in a different order hash equal, disabled connections are ignored.
+	 *  Weights and biases are rounded to multiples of precision, 0 uses their exact value.
+	 *  @param [in] g const EvoAI::Genome&
+	 *  @param [in] precision double >= 0
+	 *  @return GenomeHash
+	 */
+	GenomeHash hashGenome(const EvoAI::Genome& g, double precision = defaultHashPrecision) noexcept;
+	/**
+	 *  @brief structural hash of every genome of dna in order.
+	 *  @param [in] dna const DNA&
+	 *  @param [in] precision double >= 0
+	 *  @return GenomeHash
+	 */
+	GenomeHash hashDNA(const DNA& dna, double precision = defaultHashPrecision) noexcept;
+} // namespace fe
+
+#endif // FLOWER_EVOLVER_GENOME_HASH_HPP
@@ -0,0 +1,68 @@
+#ifndef FLOWER_EVOLVER_GENOME_REGISTRY_HPP
+#define FLOWER_EVOLVER_GENOME_REGISTRY_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <DNA.hpp>
+#include <CPPN.hpp>
+
+namespace fe{
+	/**
+	 *  @brief a genome kept by the registry, parsed and with the petals cppn compiled.
+	 */
+	struct LoadedGenome final{
+		/// the flower dna (stats genome and petals genome)
+		DNA dna;
+		/// compiled dna[1], it is kept even if the CPPN cache evicts it
+		std::shared_ptr<const CPPN> petals;
+	};
+	/**
+	 *  @brief parses a flower and keeps it until it is released or evicted.
+	 *
+	 *  The registry is a least recently used cache of handles, exports that take a handle
+	 *  don't parse the JSON or compile the networks again.
+	 *  @code
+	 *      auto handle = fe::loadGenome(flowerJson);
+	 *      auto genome = fe::getGenome(handle);
+	 *      fe::draw(fe::Petals::Type::TrunkAndPetals, petals, *genome->petals);
+	 *      fe::releaseGenome(handle);
+	 *  @endcode
+	 *  @param [in] flower const std::string& {"Flower": {"dna": ...}}
+	 *  @throw std::invalid_argument if it can't be parsed, the dna doesn't have 2 genomes or the limit is 0
+	 *  @return int handle > 0, handles are not reused
+	 */
+	int loadGenome(const std::string& flower);
+	/**
+	 *  @brief loadGenome from a dna.
+	 *  @param [in] dna DNA&&
+	 *  @throw std::invalid_argument if the dna doesn't have 2 genomes or the limit is 0
+	 *  @return int handle > 0
+	 */
+	int loadGenome(DNA&& dna);
+	/**
+	 *  @brief removes a genome from the registry, it is kept alive while it is in use.
+	 *  @param [in] handle int
+	 *  @return bool false if the handle was unknown
+	 */
+	bool releaseGenome(int handle) noexcept;
+	/**
+	 *  @brief gets a loaded genome.
+	 *  @param [in] handle int
+	 *  @throw std::invalid_argument if the handle was released, evicted or never loaded
+	 *  @return std::shared_ptr<const LoadedGenome>
+	 */
+	std::shared_ptr<const LoadedGenome> getGenome(int handle);
+	/**
+	 *  @brief sets how many genomes the registry keeps (256 by default), the least recently used ones are evicted.
+	 *  @param [in] maxGenomes std::size_t 0 releases them all and loadGenome throws until it is raised
+	 */
+	void setGenomeLimit(std::size_t maxGenomes) noexcept;
+	/**
+	 *  @brief releases all the genomes.
+	 */
+	void clearGenomes() noexcept;
+} // namespace fe
+
+#endif // FLOWER_EVOLVER_GENOME_REGISTRY_HPP
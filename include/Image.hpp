@@ -4,6 +4,7 @@
 #include <vector>
 #include <memory>
 #include <cstdint>
+#include <string>
 
 #include <SFML/Graphics/Color.hpp>
 #include <SFML/System/Vector2.hpp>
@@ -72,20 +73,70 @@ namespace fe{
      * @return bool
      */
     inline bool isBase64(unsigned char c);
+    /**
+     * @brief chars of the base64 of size bytes, padding included.
+     * @param size std::size_t
+     * @return std::size_t
+     */
+    std::size_t base64Size(std::size_t size) noexcept;
+    /**
+     * @brief encodes data to base64 into a buffer of the caller.
+     * @param data const std::uint8_t*
+     * @param size std::size_t
+     * @param out char* at least base64Size(size) chars, it isn't null terminated.
+     * @return char* past the last char written
+     */
+    char* encodeToBase64(const std::uint8_t* data, std::size_t size, char* out) noexcept;
+    /**
+     * @brief appends the base64 of data to out without intermediate strings, i.e. after a "data:image/png;base64,"
+     * @param out std::string& reserve base64Size(size) more to avoid reallocating.
+     * @param data const std::uint8_t*
+     * @param size std::size_t
+     */
+    void appendBase64(std::string& out, const std::uint8_t* data, std::size_t size);
     /**
      * @brief encodes an image to base64
      * @param data std::vector<std::uint8_t>&
      * @return std::string base64 image 
      */
     std::string encodeToBase64(const std::vector<std::uint8_t>& data);
+    /**
+     * @brief options for encodeImageToPngInMemory, speed vs size.
+     */
+    struct PngOptions final{
+        /// zlib compression level [0, 9], 0 stores the rows without compressing them, 1-3 are fast (greedy matching).
+        int level{4};
+        /// 0 to 4 uses none, sub, up, average or paeth for every row, -1 tries them on a band of rows
+        /// (and picking the filter of each row by the sum of its bytes) and uses the one that compresses best.
+        int filter{-1};
+    };
+    /**
+     * @brief Encodes raw image data into a PNG byte stream in png, it is written in place
+     *        so a buffer reused between calls doesn't allocate once it is big enough.
+     *
+     * @param image The Image object containing raw pixel data. expected RBGA
+     * @param png std::vector<std::uint8_t>& output, empty if the image is invalid.
+     * @param options const PngOptions& compression level and filter.
+     */
+    void encodeImageToPng(const Image& image, std::vector<std::uint8_t>& png, const PngOptions& options = PngOptions{});
     /**
      * @brief Encodes raw image data into a PNG byte stream in memory.
      *
      * @param image The Image object containing raw pixel data. expected RBGA
+     * @param options const PngOptions& compression level and filter.
      * @return A std::vector<std::uint8_t> containing the PNG-encoded data.
      *         Returns an empty vector if encoding fails or the input image is invalid.
      */
-    std::vector<std::uint8_t> encodeImageToPngInMemory(const Image& image);
+    std::vector<std::uint8_t> encodeImageToPngInMemory(const Image& image, const PngOptions& options = PngOptions{});
+    /**
+     * @brief Encodes raw image data into a QOI byte stream in memory (https://qoiformat.org),
+     *        lossless, several times faster to encode than PNG but bigger.
+     *
+     * @param image The Image object containing raw pixel data. expected RBGA
+     * @return A std::vector<std::uint8_t> containing the QOI-encoded data.
+     *         Returns an empty vector if the input image is invalid.
+     */
+    std::vector<std::uint8_t> encodeImageToQoiInMemory(const Image& image);
 } // namespace fe
 
 #endif // FLOWER_EVOLVER_IMAGE_HPP
@@ -0,0 +1,37 @@
+#ifndef FLOWER_EVOLVER_JSON_READER_HPP
+#define FLOWER_EVOLVER_JSON_READER_HPP
+
+#include <string>
+
+#include <DNA.hpp>
+#include <JsonBox.h>
+
+namespace fe{
+	/**
+	 *  @brief reads the dna of a Flower.json in a single pass.
+	 *
+	 *  The petals and every key but Flower.dna.genomes are skipped without making JsonBox values and
+	 *  each genome is moved into the DNA instead of copying the dna object. Each genome is still
+	 *  parsed into a JsonBox::Object, EvoAI::Genome can only be made from one.
+	 *  Documents it can't read are given to JsonBox so it accepts the same ones as before.
+	 *  @code
+	 *      auto dna = fe::readFlowerDNA(flowerJson);
+	 *  @endcode
+	 *  @param [in] flower const std::string& stringified {"Flower": {"dna": {"genomes": [...]}}}
+	 *  @param [in] name   const std::string& name used in the error, i.e. "flower1"
+	 *  @throw std::invalid_argument if it doesn't have a dna.
+	 *  @return DNA
+	 */
+	DNA readFlowerDNA(const std::string& flower, const std::string& name = "flower");
+	/**
+	 *  @brief reads the petals of a Flower.json in a single pass, the dna is skipped.
+	 *  @code
+	 *      auto radius = fe::readFlowerPetals(flowerJson)["radius"].tryGetInteger(64);
+	 *  @endcode
+	 *  @param [in] flower const std::string& stringified {"Flower": {"petals": {...}}}
+	 *  @return JsonBox::Object Flower.petals, empty if it doesn't have one.
+	 */
+	JsonBox::Object readFlowerPetals(const std::string& flower);
+} // namespace fe
+
+#endif // FLOWER_EVOLVER_JSON_READER_HPP
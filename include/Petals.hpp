@@ -1,9 +1,13 @@
 #ifndef FLOWER_EVOLVER_PETALS_HPP
 #define FLOWER_EVOLVER_PETALS_HPP
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
+#include <CPPN.hpp>
 #include <Image.hpp>
 #include <MathUtils.hpp>
 
@@ -73,50 +77,200 @@ namespace fe{
 		/**
 		*  @brief queries the neural network
 		 *  
-		 *  @param [in] nn            EvoAI::NeuralNetwork with 4 inputs 4 outputs
+		 *  @param [in] nn            CPPN with 4 inputs 4 outputs
 		 *  @param [in] petals        Petals that is being processed
 		 *  @param [in] pos           position
 		 *  @param [in] currentRadius current radius
 		 *  @param [in] currentLayer  current layer
-		 *  @return std::vector<double> results
+		 *  @return std::array<double, 4> results
 		 */
-		std::vector<double> queryNN(EvoAI::NeuralNetwork& nn, Petals& petals, const sf::Vector2f& pos, int currentRadius, int currentLayer) noexcept;
+		std::array<double, 4> queryNN(const CPPN& nn, Petals& petals, const sf::Vector2f& pos, int currentRadius, int currentLayer) noexcept;
 		/**
 		 *  @brief sets color for every pixel in a line from petals.origin to pos as maximum if no cut is made.
 		 *  
 		 *  @param [in] pos           sf::Vector2f& position
-		 *  @param [in] nn            EvoAI::NeuralNetwork with 4 inputs and 4 outputs
+		 *  @param [in] nn            CPPN with 4 inputs and 4 outputs
 		 *  @param [in] petals        Petals that is being processed
 		 *  @param [in] currentRadius current radius
 		 *  @param [in] currentLayer  current layer
 		 */
-		void setColorAndCut(const sf::Vector2f& pos, EvoAI::NeuralNetwork& nn, Petals& petals, int currentRadius, int currentLayer) noexcept;
+		void setColorAndCut(const sf::Vector2f& pos, const CPPN& nn, Petals& petals, int currentRadius, int currentLayer) noexcept;
 		/**
 		 *  @brief It will use setColorAndCut to draw a pattern into petals.
 		 *  
 		 *  @param [in] origin        center of circle (Flower)
 		 *  @param [in] r             max radius
 		 *  @param [in] petals        Petals
-		 *  @param [in] nn            EvoAI::NeuralNetwork with 4 inputs 4 outputs
+		 *  @param [in] nn            CPPN with 4 inputs 4 outputs
 		 *  @param [in] currentRadius current Radius
 		 *  @param [in] currentLayer  current Layer
 		 */
-		void EightWaySymmetricSetColor(const sf::Vector2f& origin, const sf::Vector2f& r, Petals& petals, EvoAI::NeuralNetwork& nn, int currentRadius, int currentLayer) noexcept;
+		void EightWaySymmetricSetColor(const sf::Vector2f& origin, const sf::Vector2f& r, Petals& petals, const CPPN& nn, int currentRadius, int currentLayer) noexcept;
 		/**
-		 *  @brief will draw the flower
+		 *  @brief will draw the flower marching a ray from the origin for every point of a midpoint circle
+		 *         (reference implementation, pixels near the origin are evaluated and written many times)
 		 *  
 		 *  @param [in] petals        Petals
-		 *  @param [in] nn            EvoAI::NeuralNetwork with 4 inputs 4 outputs
+		 *  @param [in] nn            CPPN with 4 inputs 4 outputs
 		 *  @param [in] currentRadius current Radius
 		 *  @param [in] currentLayer  current Layer
 		 */
-		void drawPetals(Petals& petals, EvoAI::NeuralNetwork& nn, int currentRadius, int currentLayer) noexcept;
+		void drawPetalsRayMarch(Petals& petals, const CPPN& nn, int currentRadius, int currentLayer) noexcept;
+		/**
+		 *  @brief will draw the flower visiting every pixel of the layer once.
+		 *  
+		 *  It evaluates the cut (rMax) once per ray class of the PolarTable, a pixel is written if a ray
+		 *  sampling it reaches it and takes the color of the last of those rays the marcher would write,
+		 *  outer layers get the color once per class, inner layers once per class and step. It writes the
+		 *  same pixels as drawPetalsRayMarch, the colors match within fe::priv::rasterTolerance.
+		 *  
+		 *  @param [in] petals        Petals
+		 *  @param [in] nn            CPPN with 4 inputs 4 outputs
+		 *  @param [in] currentRadius current Radius
+		 *  @param [in] currentLayer  current Layer
+		 */
+		void drawPetals(Petals& petals, const CPPN& nn, int currentRadius, int currentLayer) noexcept;
+		/**
+		 *  @brief drawPetals for a layer that is under the ones already drawn.
+		 *  
+		 *  Pixels with occupancy set are owned by a nearer layer, they are skipped without querying
+		 *  the CPPN, the pixels written are set in occupancy. It needs currentRadius > 0.
+		 *  
+		 *  @param [in] petals        Petals
+		 *  @param [in] nn            CPPN with 4 inputs 4 outputs
+		 *  @param [in] currentRadius current Radius
+		 *  @param [in] currentLayer  current Layer
+		 *  @param [in,out] occupancy std::vector<std::uint8_t>& one per pixel (y * width + x), it is resized to the image.
+		 */
+		void drawPetalsFrontToBack(Petals& petals, const CPPN& nn, int currentRadius, int currentLayer, std::vector<std::uint8_t>& occupancy) noexcept;
+		/**
+		 *  @brief draws every layer of petals, the same image as drawPetals from petals.numLayers to 0.
+		 *  
+		 *  Inner layers overwrite the outer ones so it draws them first with drawPetalsFrontToBack and
+		 *  the outer layers only query the CPPN for the pixels that stay visible.
+		 *  
+		 *  @param [in] petals Petals
+		 *  @param [in] nn     CPPN with 4 inputs 4 outputs
+		 */
+		void drawAllPetals(Petals& petals, const CPPN& nn) noexcept;
+		/**
+		 *  @brief the geometry drawPetals needs for a layer, it doesn't depend on the genome.
+		 *  
+		 *  Rays are the ones of drawPetalsRayMarch in the order it marches them, every pixel has
+		 *  the (ray, step) samples that land on it last written first, so the pixel takes the first
+		 *  one that reaches it. Rays whose CPPN input sin(P * angle) is the same (within
+		 *  RenderOptions::periodTolerance) are in the same class and share the evaluations,
+		 *  for an integer P that is one class per point of a petal period.
+		 */
+		struct PolarTable final{
+			/**
+			 *  @brief a ray that samples a pixel.
+			 */
+			struct Candidate final{
+				/// index in angles
+				std::uint16_t ray;
+				/// the ray reaches the pixel if step <= rMax
+				std::int16_t step;
+			};
+			/**
+			 *  @brief a pixel with at least a Candidate.
+			 */
+			struct Pixel final{
+				std::uint16_t x;
+				std::uint16_t numCandidates;
+				std::uint32_t firstCandidate;
+			};
+			/**
+			 *  @brief constructor
+			 *  @param [in] originRadius int Petals::radius, the origin is (originRadius, originRadius)
+			 *  @param [in] layerRadius  int radius of the layer
+			 *  @param [in] P            float Petals::P
+			 *  @param [in] width        int image width
+			 *  @param [in] height       int image height
+			 *  @param [in] periodTolerance float RenderOptions::periodTolerance
+			 */
+			PolarTable(int originRadius, int layerRadius, float P, int width, int height, float periodTolerance) noexcept;
+			/**
+			 *  @brief memory used by the table.
+			 *  @return std::size_t bytes
+			 */
+			std::size_t getSizeInBytes() const noexcept;
+			// data
+			/// sin(P * directedAngle) of each ray
+			std::vector<float> angles;
+			/// class of each ray
+			std::vector<std::uint16_t> classes;
+			/// sin(P * directedAngle) of each class
+			std::vector<float> classAngles;
+			/// row of pixels[rows[0]]
+			int firstRow;
+			/// pixels of row firstRow + i are [rows[i], rows[i+1])
+			std::vector<std::uint32_t> rows;
+			std::vector<Pixel> pixels;
+			std::vector<Candidate> candidates;
+		};
+		/**
+		 *  @brief gets the PolarTable from the cache or makes it.
+		 *  
+		 *  Tables are kept while they fit in the cache limit and get evicted least recently used first.
+		 *  @param [in] petals      const Petals& it uses radius, P and the image size
+		 *  @param [in] layerRadius int radius of the layer
+		 *  @param [in] periodTolerance float RenderOptions::periodTolerance
+		 *  @return std::shared_ptr<const PolarTable>
+		 */
+		std::shared_ptr<const PolarTable> getPolarTable(const Petals& petals, int layerRadius, float periodTolerance) noexcept;
+		/**
+		 *  @brief sets the memory limit of the PolarTable cache (1/8 of the wasm heap or 8 MB natively by default).
+		 *  @param [in] bytes std::size_t 0 disables the cache
+		 */
+		void setPolarTableCacheLimit(std::size_t bytes) noexcept;
+		/**
+		 *  @brief removes all the cached PolarTable.
+		 */
+		void clearPolarTables() noexcept;
 		/**
 		 *  @brief will draw a trunk of the flower
 		 *  
 		 *  @param [in] petals Petals
 		 */
 		void drawTrunk(Petals& petals) noexcept;
+		/**
+		 *  @brief how much drawPetals can differ from drawPetalsRayMarch.
+		 */
+		struct RasterTolerance final{
+			/// pixels covered by only one of them / pixels covered by drawPetalsRayMarch
+			double coverage;
+			/// mean absolute difference per channel [0, 255] of the pixels covered by both
+			double meanColorError;
+			/// below this many covered pixels a single pixel is over the bounds so any difference is accepted
+			std::size_t minCoveredPixels;
+		};
+		/// both write the same pixels, with the default RenderOptions the colors only differ by the rounding
+		/// of the angle input, less than one step of a channel. fe-bench --check enforces it.
+		constexpr RasterTolerance rasterTolerance{0.002, 1.0, 500};
+		/**
+		 *  @brief the difference between two rasters.
+		 */
+		struct RasterDiff final{
+			double coverage{0.0};
+			double meanColorError{0.0};
+			/// pixels covered by the reference
+			std::size_t coveredPixels{0};
+			/**
+			 *  @brief is the difference within the tolerance.
+			 *  @param [in] tolerance const RasterTolerance&
+			 *  @return bool
+			 */
+			bool isWithin(const RasterTolerance& tolerance) const noexcept;
+		};
+		/**
+		 *  @brief the difference between two images of the same size.
+		 *  
+		 *  @param [in] reference Image
+		 *  @param [in] other     Image
+		 *  @return RasterDiff
+		 */
+		RasterDiff compareRasters(const Image& reference, const Image& other) noexcept;
 	} // namespace priv/
 	/**
 	 * @brief Determines the number of times a number can be divided by a given divisor until it is <= 1.
@@ -143,5 +297,22 @@ namespace fe{
 	 *  @param [in] g      a cppn EvoAI::Genome with 4 inputs 4 outputs
 	 */
 	void draw(Petals::Type t, Petals& petals, EvoAI::Genome& g) noexcept;
+	/**
+	 *  @brief drawLayer with a compiled cppn, i.e. the one kept by the genome registry.
+	 *  
+	 *  @param [in] petals Petals
+	 *  @param [in] nn     CPPN with 4 inputs 4 outputs
+	 *  @param [in] layer  the layer to draw
+	 *  @param [in] applyLayeredRadiusScaling it will divide the radius / 2.0 from petals.numLayers to layer
+	 */
+	void drawLayer(Petals& petals, const CPPN& nn, int layer, bool applyLayeredRadiusScaling = true) noexcept;
+	/**
+	 *  @brief draw with a compiled cppn, i.e. the one kept by the genome registry.
+	 *  
+	 *  @param [in] t      Petals::Type
+	 *  @param [in] petals Petals
+	 *  @param [in] nn     CPPN with 4 inputs 4 outputs
+	 */
+	void draw(Petals::Type t, Petals& petals, const CPPN& nn) noexcept;
 }
 #endif // FLOWER_EVOLVER_PETALS_HPP
@@ -0,0 +1,68 @@
+#ifndef FLOWER_EVOLVER_PLATFORM_HPP
+#define FLOWER_EVOLVER_PLATFORM_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#include <Image.hpp>
+
+/**
+ * @brief it will copy the ptr buffer into the canvas with id "canvas"
+ *        (or self.canvas inside a worker) with putImageData, the wasm memory is shared (-pthread)
+ *        so the pixels are copied once into the ImageData, in native builds it will
+ *        copy it into an in-memory image, see fe::platform::getCanvas()
+ * @param ptr std::uint8_t* buffer to copy to canvas
+ * @param w int width for the canvas
+ * @param h int height for the canvas
+ */
+void copyToCanvas(std::uint8_t* ptr, int w, int h);
+
+namespace fe::platform{
+	/**
+	 * @brief memory usage of the allocator in bytes.
+	 */
+	struct HeapStats final{
+		/// size of the memory (wasm heap), 0 in native builds.
+		std::size_t heapSize{0};
+		/// bytes the allocator got from the system.
+		std::size_t footprint{0};
+		/// high-water mark of footprint, the allocator keeps it in web builds, native builds only
+		/// see the footprint when getHeapStats is called so it's the largest one sampled.
+		std::size_t maxFootprint{0};
+		/// bytes currently allocated.
+		std::size_t inUse{0};
+	};
+	/**
+	 * @brief gets the allocator memory usage.
+	 * @return HeapStats
+	 */
+	HeapStats getHeapStats() noexcept;
+	/**
+	 * @brief largest size the heap can get to, the wasm heap is fixed (-sTOTAL_MEMORY), 0 in native builds.
+	 * @return std::size_t
+	 */
+	std::size_t getHeapMax() noexcept;
+	/**
+	 * @brief default memory limit of a cache, a fraction of the heap capped at maxBytes.
+	 * @param divisor std::size_t the cache gets getHeapMax() / divisor
+	 * @param maxBytes std::size_t limit when the heap isn't limited (native builds)
+	 * @return std::size_t
+	 */
+	inline std::size_t getCacheBudget(std::size_t divisor, std::size_t maxBytes) noexcept{
+		const auto heapMax = getHeapMax();
+		return heapMax == 0 ? maxBytes:std::min(heapMax / divisor, maxBytes);
+	}
+} // namespace fe::platform
+
+#ifndef __EMSCRIPTEN__
+namespace fe::platform{
+	/**
+	 * @brief gets the in-memory canvas, it holds the last image given to copyToCanvas.
+	 * @return const fe::Image&
+	 */
+	const fe::Image& getCanvas() noexcept;
+} // namespace fe::platform
+#endif
+
+#endif // FLOWER_EVOLVER_PLATFORM_HPP
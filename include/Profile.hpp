@@ -0,0 +1,106 @@
+#ifndef FLOWER_EVOLVER_PROFILE_HPP
+#define FLOWER_EVOLVER_PROFILE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <JsonBox.h>
+
+namespace fe::profile{
+	/**
+	 * @brief counters updated by the hot paths.
+	 */
+	enum class Counter : std::size_t{
+		NNForward,
+		PixelsWritten,
+		PixelsOccluded,
+		ContourPoints,
+		SimplifiedPoints,
+		Vertices,
+		Faces,
+		PngBytes,
+		Base64Bytes,
+		JsonBytes,
+		CPPNCacheHits,
+		CPPNCacheMisses,
+		JsonReaderFallbacks,
+		Count
+	};
+	/**
+	 * @brief scoped timers, they are inclusive (PetalLayer includes NormalMap, EncodePng and Base64).
+	 */
+	enum class Timer : std::size_t{
+		DrawPetals,
+		DrawTrunk,
+		FindContour,
+		SimplifyContour,
+		PetalLayer,
+		NormalMap,
+		EncodePng,
+		Base64,
+		GltfToJson,
+		GltfToJsonStr,
+		Count
+	};
+	/**
+	 * @brief is profiling compiled in (FE_ENABLE_PROFILING)
+	 * @return bool
+	 */
+	constexpr bool isEnabled() noexcept{
+	#ifdef FE_ENABLE_PROFILING
+		return true;
+	#else
+		return false;
+	#endif
+	}
+	/**
+	 * @brief adds n to the counter.
+	 * @param c Counter
+	 * @param n std::uint64_t
+	 */
+	void count(Counter c, std::uint64_t n) noexcept;
+	/**
+	 * @brief adds a call of ns nanoseconds to the timer.
+	 * @param t Timer
+	 * @param ns std::uint64_t
+	 */
+	void addTime(Timer t, std::uint64_t ns) noexcept;
+	/**
+	 * @brief it will add the time from construction to destruction to a Timer.
+	 */
+	class ScopedTimer final{
+		public:
+			explicit ScopedTimer(Timer t) noexcept;
+			ScopedTimer(const ScopedTimer&) = delete;
+			ScopedTimer& operator=(const ScopedTimer&) = delete;
+			~ScopedTimer() noexcept;
+		private:
+			Timer m_timer;
+			std::chrono::steady_clock::time_point m_start;
+	};
+	/**
+	 * @brief gets the counters and timers.
+	 * @return JsonBox::Value {"enabled", "timers": {name: {"calls", "ms"}}, "counters": {name: n}}
+	 */
+	JsonBox::Value toJson() noexcept;
+	/**
+	 * @brief sets all the counters and timers to 0.
+	 */
+	void reset() noexcept;
+} // namespace fe::profile
+
+#define FE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define FE_PROFILE_CONCAT(a, b) FE_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef FE_ENABLE_PROFILING
+	/// adds n to fe::profile::Counter::counter
+	#define FE_PROFILE_COUNT(counter, n) fe::profile::count(fe::profile::Counter::counter, static_cast<std::uint64_t>(n))
+	/// times the rest of the scope into fe::profile::Timer::timer
+	#define FE_PROFILE_SCOPE(timer) const fe::profile::ScopedTimer FE_PROFILE_CONCAT(feProfileTimer, __LINE__)(fe::profile::Timer::timer)
+#else
+	#define FE_PROFILE_COUNT(counter, n) ((void)0)
+	#define FE_PROFILE_SCOPE(timer) ((void)0)
+#endif
+
+#endif // FLOWER_EVOLVER_PROFILE_HPP
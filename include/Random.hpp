@@ -0,0 +1,156 @@
+#ifndef FLOWER_EVOLVER_RANDOM_HPP
+#define FLOWER_EVOLVER_RANDOM_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+namespace fe{
+	/**
+	 *  @brief counter based random numbers (SplitMix64 of a key and a counter).
+	 *
+	 *  The i-th number of a stream only depends on (seed, stream, i), so every thread, tile or
+	 *  pixel can have its own stream and the results don't depend on the order they run in.
+	 *  @code
+	 *      fe::Random rng(seed, y * width + x);
+	 *      auto jitter = rng.random(-0.4f, 0.4f);
+	 *  @endcode
+	 */
+	class Random final{
+		public:
+			/**
+			 *  @brief constructor
+			 *  @param [in] seed   std::uint64_t
+			 *  @param [in] stream std::uint64_t streams of the same seed are independent
+			 */
+			explicit Random(std::uint64_t seed, std::uint64_t stream = 0) noexcept;
+			/**
+			 *  @brief a stream derived from this one, it doesn't advance it.
+			 *  @param [in] stream std::uint64_t
+			 *  @return Random
+			 */
+			Random split(std::uint64_t stream) const noexcept;
+			/**
+			 *  @brief next 64 bits.
+			 *  @return std::uint64_t
+			 */
+			std::uint64_t next() noexcept;
+			/**
+			 *  @brief uniform in [min, max], they are swapped if min > max.
+			 *  @return int
+			 */
+			int random(int min, int max) noexcept;
+			/**
+			 *  @brief uniform in [min, max), they are swapped if min > max.
+			 *  @return float
+			 */
+			float random(float min, float max) noexcept;
+			/**
+			 *  @brief uniform in [min, max), they are swapped if min > max.
+			 *  @return double
+			 */
+			double random(double min, double max) noexcept;
+			/**
+			 *  @brief true with probability rate.
+			 *  @return bool
+			 */
+			bool random(double rate) noexcept;
+		private:
+			std::uint64_t m_key;
+			std::uint64_t m_counter;
+	};
+	/**
+	 *  @brief streams of a request.
+	 */
+	enum class RandomStream : std::uint64_t{
+		/// seeds EvoAI::randomGen() (genome creation, mutation and reproduction)
+		EvoAI,
+		/// noise of the normal maps, one seed per petal layer
+		NormalMap
+	};
+	/**
+	 *  @brief the random state of an export, create it before anything random happens.
+	 *
+	 *  The outermost request of a thread takes the seed given to setSeed or a new one from the clock,
+	 *  nested requests use the outer one. Exports that only draw don't need one.
+	 *  @code
+	 *      std::string makeFlower(...){
+	 *          fe::RandomRequest request;
+	 *          ...
+	 *      }
+	 *  @endcode
+	 */
+	class RandomRequest final{
+		public:
+			/**
+			 *  @brief starts a request.
+			 */
+			RandomRequest() noexcept;
+			RandomRequest(const RandomRequest&) = delete;
+			RandomRequest& operator=(const RandomRequest&) = delete;
+			/**
+			 *  @brief ends the request.
+			 */
+			~RandomRequest();
+			/**
+			 *  @brief seed of the request.
+			 *  @return std::uint64_t
+			 */
+			std::uint64_t getSeed() const noexcept;
+		private:
+			std::uint64_t m_seed;
+	};
+	/**
+	 *  @brief locks EvoAI::randomGen() while genomes are created, mutated or reproduced.
+	 *
+	 *  EvoAI::randomGen() is global and not thread safe, it is locked only around the EvoAI calls so
+	 *  the draws of other threads don't wait for it. Inside a request each one seeds it from the next
+	 *  sub stream of the EvoAI stream, nested ones use the outer one.
+	 *  @code
+	 *      fe::RandomRequest request;
+	 *      {
+	 *          fe::EvoAIRandom evoai;
+	 *          dna.mutate(rates);
+	 *      }
+	 *      fe::Flower mutated({0.0, 0.0}, radius, numLayers, P, bias, std::move(dna));
+	 *  @endcode
+	 */
+	class EvoAIRandom final{
+		public:
+			/**
+			 *  @brief locks and seeds EvoAI::randomGen().
+			 */
+			EvoAIRandom() noexcept;
+			EvoAIRandom(const EvoAIRandom&) = delete;
+			EvoAIRandom& operator=(const EvoAIRandom&) = delete;
+			/**
+			 *  @brief unlocks EvoAI::randomGen().
+			 */
+			~EvoAIRandom();
+		private:
+			std::unique_lock<std::mutex> m_lock;
+	};
+	/**
+	 *  @brief every request uses this seed until clearSeed, the same calls with the same seed give the same results.
+	 *  @param [in] seed std::uint64_t
+	 */
+	void setSeed(std::uint64_t seed) noexcept;
+	/**
+	 *  @brief requests take a new seed from the clock (default).
+	 */
+	void clearSeed() noexcept;
+	/**
+	 *  @brief the seed given to setSeed.
+	 *  @return std::optional<std::uint64_t> empty if requests use the clock
+	 */
+	std::optional<std::uint64_t> getSeed() noexcept;
+	/**
+	 *  @brief a stream of the current request of the thread (seed 0 without one).
+	 *  @param [in] stream RandomStream
+	 *  @param [in] index  std::uint64_t sub stream, i.e. the layer
+	 *  @return Random
+	 */
+	Random getRandom(RandomStream stream, std::uint64_t index = 0) noexcept;
+} // namespace fe
+
+#endif // FLOWER_EVOLVER_RANDOM_HPP
@@ -0,0 +1,69 @@
+#ifndef FLOWER_EVOLVER_RENDER_OPTIONS_HPP
+#define FLOWER_EVOLVER_RENDER_OPTIONS_HPP
+
+#include <JsonBox.h>
+
+namespace fe{
+	/**
+	 *  @brief options of the petals renderer, they don't change the genome or the Flower json.
+	 *  @code
+	 *      fe::RenderOptions options;
+	 *      options.periodTolerance = 1e-5f; // share the rays of every petal
+	 *      fe::setRenderOptions(options);
+	 *  @endcode
+	 */
+	struct RenderOptions final{
+		/**
+		 *  @brief default constructor
+		 */
+		RenderOptions() = default;
+		/**
+		 *  @brief deserializable constructor, missing keys get the default values.
+		 *  @param o JsonBox::Object
+		 *  @throw std::invalid_argument if a value is out of range.
+		 */
+		RenderOptions(JsonBox::Object o);
+		/**
+		 *  @brief serializes the options.
+		 *  @return JsonBox::Object
+		 */
+		JsonBox::Object toJson() const noexcept;
+		/// largest periodTolerance accepted.
+		static constexpr float maxPeriodTolerance = 1e-4f;
+		/// largest sampleTolerance accepted.
+		static constexpr float maxSampleTolerance = 1.0f;
+		// data
+		/**
+		 *  The CPPN sees the angle as sin(P * angle) so rays of different petals (and mirrored
+		 *  within a petal) get the same input, rays whose inputs differ up to this share the
+		 *  evaluations [0, maxPeriodTolerance], 0 (default) only shares identical inputs so it is
+		 *  exact, with a tolerance each ray gets an input up to tolerance / 2 away from its own.
+		 */
+		float periodTolerance{0.0f};
+		/**
+		 *  Inner layers query the CPPN for the radius input of every pixel, with a tolerance they
+		 *  sample it on a coarse grid of (ray, step) and refine the cells where it is farther than
+		 *  this from linear, the rest is interpolated, [0, maxSampleTolerance], 0 queries every
+		 *  pixel (strict, exact).
+		 */
+		float sampleTolerance{0.0f};
+		/**
+		 *  Threads of fe::getThreadPool() that render a layer, the rows are split in tiles and the
+		 *  CPPN evaluations in chunks, the image is the same for any number of threads,
+		 *  0 uses all of them, 1 renders in the calling thread.
+		 */
+		int numThreads{0};
+	};
+	/**
+	 *  @brief sets the options used by the next draws.
+	 *  @param options const RenderOptions&
+	 */
+	void setRenderOptions(const RenderOptions& options) noexcept;
+	/**
+	 *  @brief gets the current options.
+	 *  @return RenderOptions
+	 */
+	RenderOptions getRenderOptions() noexcept;
+} // namespace fe
+
+#endif // FLOWER_EVOLVER_RENDER_OPTIONS_HPP
@@ -42,6 +42,15 @@ namespace fe{
 		 * @param terrainType int terrain type
 		 */
 		Stats(const std::string& genome, float humidity, int temperature, int altitude, int terrainType);
+		/**
+		 * @brief constructor to build stats from the flower DNA.
+		 * @param dna const DNA& it needs 2 genomes
+		 * @param humidity float 0.0 to 1.0
+		 * @param temperature int temperature
+		 * @param altitude int meters above sea
+		 * @param terrainType int terrain type
+		 */
+		Stats(const DNA& dna, float humidity, int temperature, int altitude, int terrainType);
 		/**
 		 * @brief convert to json
 		 * @return JsonBox::Object
@@ -0,0 +1,90 @@
+#ifndef FLOWER_EVOLVER_THREAD_POOL_HPP
+#define FLOWER_EVOLVER_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fe{
+	/**
+	 *  @brief work stealing thread pool.
+	 *
+	 *  run splits the tasks in contiguous blocks, one per thread, every thread takes tasks from the
+	 *  front of its block and when it is empty steals from the back of the others. The caller is one
+	 *  of the threads and run returns when every task is done, so tasks can use the caller stack.
+	 *  Tasks run in any order and thread, the results should only depend on the task index.
+	 *  @code
+	 *      std::vector<double> out(n);
+	 *      fe::getThreadPool().run(n, 0, [&](std::size_t task){
+	 *          out[task] = compute(task);
+	 *      });
+	 *  @endcode
+	 */
+	class ThreadPool final{
+		public:
+			/**
+			 *  @brief starts the workers.
+			 *  @param [in] numWorkers std::size_t threads besides the caller of run
+			 */
+			explicit ThreadPool(std::size_t numWorkers) noexcept;
+			ThreadPool(const ThreadPool&) = delete;
+			ThreadPool& operator=(const ThreadPool&) = delete;
+			/**
+			 *  @brief stops and joins the workers.
+			 */
+			~ThreadPool();
+			/**
+			 *  @brief number of threads that run tasks, the workers and the caller.
+			 *  @return std::size_t
+			 */
+			std::size_t getNumThreads() const noexcept;
+			/**
+			 *  @brief runs fn(task) for every task in [0, numTasks) and waits for them.
+			 *
+			 *  If the pool is busy with another run or it is called from a task, the tasks run in the caller.
+			 *  @param [in] numTasks   std::size_t
+			 *  @param [in] maxThreads std::size_t threads to use (caller included), 0 uses all of them
+			 *  @param [in] fn         const std::function<void(std::size_t)>& it shouldn't throw
+			 */
+			void run(std::size_t numTasks, std::size_t maxThreads, const std::function<void(std::size_t)>& fn) noexcept;
+		private:
+			struct Queue final{
+				std::mutex mutex;
+				std::deque<std::size_t> tasks;
+			};
+			void work(std::size_t thread) noexcept;
+			void runTasks(std::size_t thread) noexcept;
+			bool pop(std::size_t thread, std::size_t& task) noexcept;
+			bool steal(std::size_t thread, std::size_t& task) noexcept;
+		private:
+			std::vector<std::unique_ptr<Queue>> m_queues;
+			std::vector<std::thread> m_workers;
+			std::mutex m_runMutex;
+			std::mutex m_mutex;
+			std::condition_variable m_wake;
+			std::condition_variable m_done;
+			const std::function<void(std::size_t)>* m_job;
+			std::size_t m_numActive;
+			std::uint64_t m_generation;
+			std::atomic<std::size_t> m_remaining;
+			bool m_stop;
+	};
+	/**
+	 *  @brief the pool used by the renderer.
+	 *
+	 *  It has a worker less than the hardware threads, in wasm up to the
+	 *  pthread pool size (FE_THREAD_POOL_SIZE) as more threads can't start
+	 *  without returning to the event loop.
+	 *  @return ThreadPool&
+	 */
+	ThreadPool& getThreadPool() noexcept;
+} // namespace fe
+
+#endif // FLOWER_EVOLVER_THREAD_POOL_HPP
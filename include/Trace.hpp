@@ -0,0 +1,86 @@
+#ifndef FLOWER_EVOLVER_TRACE_HPP
+#define FLOWER_EVOLVER_TRACE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <JsonBox.h>
+
+namespace fe::trace{
+	/**
+	 * @brief a complete ("ph":"X") chrome trace event.
+	 */
+	struct Event final{
+		/// string literal
+		const char* name{nullptr};
+		/// microseconds since the first trace call
+		std::int64_t start{0};
+		/// microseconds
+		std::int64_t duration{0};
+		int tid{0};
+		/// optional argument name (string literal), nullptr when not used.
+		const char* argName{nullptr};
+		std::int64_t argValue{0};
+	};
+	/**
+	 * @brief enables or disables recording, it is disabled by default.
+	 * @param enabled bool
+	 */
+	void setEnabled(bool enabled) noexcept;
+	/**
+	 * @brief is recording enabled.
+	 * @return bool
+	 */
+	bool isEnabled() noexcept;
+	/**
+	 * @brief sets the ring buffer capacity, it clears the recorded events.
+	 * @param capacity std::size_t max number of events, older events get overwritten.
+	 */
+	void setCapacity(std::size_t capacity) noexcept;
+	/**
+	 * @brief records an event into the ring buffer.
+	 * @param e const Event&
+	 */
+	void record(const Event& e) noexcept;
+	/**
+	 * @brief gets the recorded events in chrome trace event format (Perfetto / chrome://tracing).
+	 * @return JsonBox::Value {"traceEvents": [...], "displayTimeUnit": "ms"}
+	 */
+	JsonBox::Value toJson() noexcept;
+	/**
+	 * @brief removes all the recorded events.
+	 */
+	void clear() noexcept;
+	/**
+	 * @brief it will record an event from construction to destruction if tracing is enabled.
+	 */
+	class Span final{
+		public:
+			/**
+			 * @brief constructor
+			 * @param name const char* string literal
+			 * @param argName const char* string literal or nullptr
+			 * @param argValue std::int64_t
+			 */
+			explicit Span(const char* name, const char* argName = nullptr, std::int64_t argValue = 0) noexcept;
+			Span(const Span&) = delete;
+			Span& operator=(const Span&) = delete;
+			~Span() noexcept;
+		private:
+			const char* m_name;
+			const char* m_argName;
+			std::int64_t m_argValue;
+			bool m_active;
+			std::chrono::steady_clock::time_point m_start;
+	};
+} // namespace fe::trace
+
+#define FE_TRACE_CONCAT_IMPL(a, b) a##b
+#define FE_TRACE_CONCAT(a, b) FE_TRACE_CONCAT_IMPL(a, b)
+/// records the rest of the scope as a span named name
+#define FE_TRACE_SPAN(name) const fe::trace::Span FE_TRACE_CONCAT(feTraceSpan, __LINE__)(name)
+/// records the rest of the scope as a span named name with an argument
+#define FE_TRACE_SPAN_ARG(name, argName, argValue) const fe::trace::Span FE_TRACE_CONCAT(feTraceSpan, __LINE__)(name, argName, static_cast<std::int64_t>(argValue))
+
+#endif // FLOWER_EVOLVER_TRACE_HPP
@@ -36,6 +36,18 @@ export const getDataUrl = async (canvas) => {
     }
     return canvas.toDataURL();
 };
+/**
+ * @brief Utility function to get the canvas image as an ImageBitmap without encoding it,
+ *        an OffscreenCanvas transfers its bitmap (it is left blank), post it with postMessage(msg, [bitmap]).
+ * @param {HTMLCanvasElement | OffscreenCanvas} canvas
+ * @returns {Promise<ImageBitmap>}
+ */
+export const getImageBitmap = async (canvas) => {
+    if(canvas instanceof OffscreenCanvas){
+        return canvas.transferToImageBitmap();
+    }
+    return await createImageBitmap(canvas);
+};
 /**
  * @brief Utility function to get the blob data from a canvas.
  * @param {HTMLCanvasElement | OffscreenCanvas} canvas 
@@ -63,6 +75,19 @@ export const getCanvasBlob = async(canvas, options) => {
         }
     });
 };
+/**
+ * @brief Utility function to copy the pixels of a render*RGBA call out of the wasm memory,
+ *        the view they return is only valid until the next render.
+ * @param {Object} rgba - {width, height, data: Uint8Array}
+ * @returns {Object} {width, height, data: Uint8ClampedArray}
+ */
+export const copyRGBA = (rgba) => {
+    return {
+        width: rgba.width,
+        height: rgba.height,
+        data: new Uint8ClampedArray(rgba.data)
+    };
+};
 /**
  * @brief A simple Flower
  */
@@ -143,6 +168,22 @@ export class FEService{
         this.canvas.width = this.params.radius * 2;
         this.canvas.height = this.params.radius * 3;
     }
+    /**
+     * @brief gets the last drawn image as an ImageBitmap, inside a worker it is transferred
+     *        from the OffscreenCanvas so it can be posted to the main thread without copies or encoding.
+     * @code
+     *  await FE.drawFlower(genome);
+     *  let bitmap = await FE.getImageBitmap();
+     *  self.postMessage({ bitmap }, [bitmap]);
+     * @endcode
+     * @returns {Promise<ImageBitmap>}
+     */
+    async getImageBitmap(){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        return await getImageBitmap(this.canvas);
+    }
     /**
      * @brief gets the currents parameters
      * @returns {FEParams}
@@ -389,6 +430,70 @@ export class FEService{
             throw Error(this.fe.getExceptionMessage(e));
         }
     }
+    /**
+     * @brief renders the flower without a canvas (node, workers, batch rendering).
+     * @param {string} genome - stringified json
+     * @returns {Object} {width, height, data: Uint8ClampedArray rgba}, new ImageData(data, width, height) in browsers.
+     */
+    renderFlowerRGBA(genome){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            return copyRGBA(this.fe.renderFlowerRGBA(genome, this.params.radius, this.params.numLayers, this.params.P, this.params.bias));
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief renders the petals without a canvas. (no stem)
+     * @param {string} genome - stringified json
+     * @returns {Object} {width, height, data: Uint8ClampedArray rgba}
+     */
+    renderPetalsRGBA(genome){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            return copyRGBA(this.fe.renderPetalsRGBA(genome, this.params.radius, this.params.numLayers, this.params.P, this.params.bias));
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief renders the petal layer without a canvas. (no stem)
+     * @param {string} genome - stringified json
+     * @param {number} layer - layer to render
+     * @returns {Object} {width, height, data: Uint8ClampedArray rgba}
+     */
+    renderPetalLayerRGBA(genome, layer){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            return copyRGBA(this.fe.renderPetalLayerRGBA(genome, this.params.radius, this.params.numLayers, this.params.P, this.params.bias, layer));
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief encodes the last flower drawn or rendered, without reading the canvas back.
+     * @param {string} format - "png" or "qoi"
+     * @param {number} effort - png compression level 0-9, higher is smaller but slower
+     * @param {number} filter - png row filter 0-4 or -1 to choose it
+     * @returns {Blob} blob - encoded image
+     */
+    encodeFlower(format = "png", effort = 4, filter = -1){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            let data = this.fe.encodeFlower(format, effort, filter);
+            return new Blob([data], { type: "image/" + format });
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
     /**
      * @bief it makes a child from two flower genomes.
      * @param {string} father - genome for father
@@ -455,4 +560,343 @@ export class FEService{
             throw Error(this.fe.getExceptionMessage(e));
         }
     }
+    /**
+     * @brief every call uses this seed until clearSeed, the same calls with the same seed and params give the same flowers and glTF.
+     * @param {number} seed integer in [0, 2^53]
+     */
+    setSeed(seed){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            this.fe.setSeed(seed);
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief every call takes a new seed from the clock (default).
+     */
+    clearSeed(){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        this.fe.clearSeed();
+    }
+    /**
+     * @brief structural hash of the flower genome, flowers with the same genes get the same hash (cache keys, dedup, etc).
+     * @param {string} genome
+     * @param {number} precision weights and biases are rounded to multiples of it, 0 is exact.
+     * @returns {string} 128 bits hash as 32 hex characters.
+     */
+    hashFlower(genome, precision = 1e-6){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            return this.fe.hashFlower(genome, precision);
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief parses the genome once and keeps it in the wasm module, the *ByHandle functions use it without parsing it again.
+     * @param {string} genome - stringified json
+     * @returns {number} handle, release it with releaseGenome when it is no longer needed.
+     */
+    loadGenome(genome){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            return this.fe.loadGenome(genome);
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief loadGenome from a binary flower.
+     * @param {Uint8Array} data - from flowerToBinary
+     * @returns {number} handle, release it with releaseGenome when it is no longer needed.
+     */
+    loadGenomeBinary(data){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            return this.fe.loadGenomeBinary(data);
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief encodes the genome in the compact binary format, it is lossless and several times smaller than the json.
+     * @param {string} genome - stringified json
+     * @returns {Uint8Array} data
+     */
+    flowerToBinary(genome){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            return this.fe.flowerToBinary(genome);
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief decodes a binary flower.
+     * @param {Uint8Array} data - from flowerToBinary
+     * @returns {string} genome - stringified json
+     */
+    binaryToFlower(data){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            return this.fe.binaryToFlower(data);
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief releases a genome loaded with loadGenome.
+     * @param {number} handle
+     * @returns {boolean} false if the handle was unknown, released or evicted.
+     */
+    releaseGenome(handle){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        return this.fe.releaseGenome(handle);
+    }
+    /**
+     * @brief sets how many genomes can be loaded at the same time, the least recently used ones are evicted.
+     * @param {number} maxGenomes - 256 by default, 0 disables loading (loadGenome throws)
+     */
+    setGenomeLimit(maxGenomes){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        this.fe.setGenomeLimit(maxGenomes);
+    }
+    /**
+     * @brief it draws the flower from a loaded genome.
+     * @param {number} handle - from loadGenome
+     * @returns {string} image - data url of the flower.
+     */
+    async drawFlowerByHandle(handle){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            this.fe.drawFlowerByHandle(handle, this.params.radius, this.params.numLayers, this.params.P, this.params.bias);
+            return await getDataUrl(this.canvas);
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief it draws the petals from a loaded genome. (no stem)
+     * @param {number} handle - from loadGenome
+     * @returns {string} image - data url of the petals.
+     */
+    async drawPetalsByHandle(handle){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        this.canvas.height = this.params.radius * 2;
+        try{
+            this.fe.drawPetalsByHandle(handle, this.params.radius, this.params.numLayers, this.params.P, this.params.bias);
+            return await getDataUrl(this.canvas);
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief it draws the petal layer from a loaded genome. (no stem)
+     * @param {number} handle - from loadGenome
+     * @param {number} layer - layer to draw
+     * @returns {string} image - data url of the petal layer.
+     */
+    async drawPetalLayerByHandle(handle, layer){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        this.canvas.height = this.params.radius * 2;
+        try{
+            this.fe.drawPetalLayerByHandle(handle, this.params.radius, this.params.numLayers, this.params.P, this.params.bias, layer);
+            return await getDataUrl(this.canvas);
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief renders the flower from a loaded genome without a canvas.
+     * @param {number} handle - from loadGenome
+     * @returns {Object} {width, height, data: Uint8ClampedArray rgba}
+     */
+    renderFlowerRGBAByHandle(handle){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            return copyRGBA(this.fe.renderFlowerRGBAByHandle(handle, this.params.radius, this.params.numLayers, this.params.P, this.params.bias));
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief renders the petals from a loaded genome without a canvas. (no stem)
+     * @param {number} handle - from loadGenome
+     * @returns {Object} {width, height, data: Uint8ClampedArray rgba}
+     */
+    renderPetalsRGBAByHandle(handle){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            return copyRGBA(this.fe.renderPetalsRGBAByHandle(handle, this.params.radius, this.params.numLayers, this.params.P, this.params.bias));
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief renders the petal layer from a loaded genome without a canvas. (no stem)
+     * @param {number} handle - from loadGenome
+     * @param {number} layer - layer to render
+     * @returns {Object} {width, height, data: Uint8ClampedArray rgba}
+     */
+    renderPetalLayerRGBAByHandle(handle, layer){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            return copyRGBA(this.fe.renderPetalLayerRGBAByHandle(handle, this.params.radius, this.params.numLayers, this.params.P, this.params.bias, layer));
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief it makes a child from two loaded genomes.
+     * @param {number} father - handle for father
+     * @param {number} mother - handle for mother
+     * @returns {Flower} flower - child flower
+     */
+    async reproduceByHandle(father, mother){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            let genome = this.fe.reproduceByHandle(father, mother, this.params.radius, this.params.numLayers, this.params.P, this.params.bias);
+            let image = await getDataUrl(this.canvas);
+            return new Flower(genome, image);
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief it mutates a loaded genome, the loaded genome doesn't change.
+     * @param {number} original - handle from original flower.
+     * @returns {Flower} flower - the new mutated flower
+     */
+    async mutateByHandle(original, addNodeRate = 0.2, addConnRate = 0.3, 
+        removeConnRate = 0.2, perturbWeightsRate = 0.6, 
+        enableRate = 0.35, disableRate = 0.3, actTypeRate = 0.4){
+            if(!this.fe){
+                throw Error("call FEService.init() before using it");
+            }
+            try{
+                let genome = this.fe.mutateByHandle(original, this.params.radius, this.params.numLayers, this.params.P, this.params.bias,
+                    addNodeRate, addConnRate, removeConnRate, perturbWeightsRate, 
+                    enableRate, disableRate, actTypeRate);
+                let image = await getDataUrl(this.canvas);
+                return new Flower(genome, image);
+            }catch(e){
+                throw Error(this.fe.getExceptionMessage(e));
+            }
+    }
+    /**
+     * @brief gets the stats of a loaded genome.
+     * @param {number} handle - from loadGenome
+     * @returns {Map} map for stats.
+     */
+    getFlowerStatsByHandle(handle, humidity = 0.5, temperature = 20, altitude = 0, terrainType = 0){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            let json = this.fe.getFlowerStatsByHandle(handle, humidity, temperature, altitude, terrainType);
+            return JSON.parse(json).stats;
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief hashFlower of a loaded genome.
+     * @param {number} handle - from loadGenome
+     * @param {number} precision weights and biases are rounded to multiples of it, 0 is exact.
+     * @returns {string} 128 bits hash as 32 hex characters.
+     */
+    hashFlowerByHandle(handle, precision = 1e-6){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            return this.fe.hashFlowerByHandle(handle, precision);
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief returns a GLTF string of a loaded genome.
+     * @param {number} handle - from loadGenome
+     * @param {String} flowerID 
+     * @param {Object} flowerParams - for the complete list of options consult include/3D/FlowerParameters.hpp
+     * @returns {Promise<String>} - GLTF file string
+     */
+    async make3DFlowerByHandle(handle, flowerID, flowerParams = {}){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            return this.fe.make3DFlowerByHandle(handle, this.params.radius, this.params.numLayers, this.params.P, this.params.bias, flowerID, JSON.stringify(flowerParams));
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief sets the options of the petals renderer, they are kept for the next draws.
+     * @param {Object} options - {periodTolerance: number [0, 1e-4], sampleTolerance: number [0, 1]} 0 is exact, {numThreads: number} 0 uses the whole thread pool, for the complete list consult include/RenderOptions.hpp
+     */
+    setRenderOptions(options){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        try{
+            this.fe.setRenderOptions(JSON.stringify(options));
+        }catch(e){
+            throw Error(this.fe.getExceptionMessage(e));
+        }
+    }
+    /**
+     * @brief sets the memory limit of the compiled genomes cache, drawFlower and make3DFlower of the same genome reuse it.
+     * @param {number} bytes - 0 disables the cache (640 KB by default)
+     */
+    setCPPNCacheLimit(bytes){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        this.fe.setCPPNCacheLimit(bytes);
+    }
+    /**
+     * @brief gets the options of the petals renderer.
+     * @returns {Object} options
+     */
+    getRenderOptions(){
+        if(!this.fe){
+            throw Error("call FEService.init() before using it");
+        }
+        return JSON.parse(this.fe.getRenderOptions());
+    }
 };
\ No newline at end of file
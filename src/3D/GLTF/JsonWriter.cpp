@@ -1,4 +1,6 @@
 #include <3D/GLTF/JsonWriter.hpp>
+#include <Profile.hpp>
+#include <Trace.hpp>
 
 #include <numeric>
 
@@ -21,6 +23,8 @@ namespace fe::gltf{
         return arr;
     }
     JsonBox::Value toJson(const fe::gltf::Scene& scene, const fe::FlowerParameters& params){
+        FE_PROFILE_SCOPE(GltfToJson);
+        FE_TRACE_SPAN("gltf::toJson");
         // glTF Constants
         [[maybe_unused]] constexpr int COMPONENT_TYPE_BYTE = 5120;
         [[maybe_unused]] constexpr int COMPONENT_TYPE_UNSIGNED_BYTE = 5121;
@@ -48,6 +52,8 @@ namespace fe::gltf{
                 return a + b.indices.size() / 3;
             }
         );
+        FE_PROFILE_COUNT(Vertices, totalVertices);
+        FE_PROFILE_COUNT(Faces, totalFaces);
         extras["vertices"] = static_cast<double>(totalVertices);
         extras["textureCoordinates"] = static_cast<double>(totalVertices);
         extras["normals"] = static_cast<double>(totalVertices);
@@ -407,7 +413,10 @@ namespace fe::gltf{
         if(!binaryBufferData.empty()){
             JsonBox::Object bufferJson;
             bufferJson["byteLength"] = static_cast<double>(binaryBufferData.size());
-            bufferJson["uri"] = "data:application/octet-stream;base64," + fe::encodeToBase64(binaryBufferData);
+            std::string bufferUri = "data:application/octet-stream;base64,";
+            bufferUri.reserve(bufferUri.size() + fe::base64Size(binaryBufferData.size()));
+            fe::appendBase64(bufferUri, binaryBufferData.data(), binaryBufferData.size());
+            bufferJson["uri"] = bufferUri;
             JsonBox::Array buffersArray;
             buffersArray.emplace_back(bufferJson);
             gltfRoot["buffers"] = buffersArray;
@@ -485,8 +494,11 @@ namespace fe::gltf{
         return JsonBox::Value(gltfRoot);
     }
     std::string toJsonStr(const JsonBox::Value& json){
+        FE_PROFILE_SCOPE(GltfToJsonStr);
+        FE_TRACE_SPAN("gltf::toJsonStr");
         std::stringstream ss;
         json.writeToStream(ss,false, false);
+        FE_PROFILE_COUNT(JsonBytes, ss.tellp());
         return ss.str();
     }
 } // namespace fe::gltf
@@ -1,13 +1,35 @@
 #include <3D/GLTF/TextureInfo.hpp>
 
 #include <Image.hpp>
+#include <RenderOptions.hpp>
+#include <ThreadPool.hpp>
+#include <Trace.hpp>
 
 namespace fe::gltf{
-    TextureInfo::TextureInfo(const std::string& tex_name, const std::string& base64_data_uri)
+    TextureInfo::TextureInfo(const std::string& tex_name, std::string base64_data_uri)
     : name(tex_name)
     , uri(std::move(base64_data_uri)){}
     TextureInfo TextureInfo::createFromImage(const std::string& tex_name, const fe::Image& raw_image){
-        auto textureUri = "data:image/png;base64," + fe::encodeToBase64(fe::encodeImageToPngInMemory(raw_image));
-        return TextureInfo(tex_name, textureUri);
+        FE_TRACE_SPAN("encodeTexture");
+        // the png buffer of the thread is reused by the next textures
+        thread_local std::vector<std::uint8_t> png;
+        fe::encodeImageToPng(raw_image, png);
+        std::string textureUri = "data:image/png;base64,";
+        textureUri.reserve(textureUri.size() + fe::base64Size(png.size()));
+        fe::appendBase64(textureUri, png.data(), png.size());
+        return TextureInfo(tex_name, std::move(textureUri));
+    }
+    std::vector<TextureInfo> TextureInfo::createFromImages(const std::vector<std::pair<std::string, const fe::Image*>>& images){
+        std::vector<std::string> uris(images.size());
+        fe::getThreadPool().run(images.size(), fe::getRenderOptions().numThreads, [&](std::size_t i){
+            uris[i] = std::move(createFromImage(images[i].first, *images[i].second).uri);
+        });
+        std::vector<TextureInfo> textures;
+        textures.reserve(images.size());
+        for(auto i=0u;i<images.size();++i){
+            textures.emplace_back(images[i].first, "");
+            textures.back().uri = std::move(uris[i]);
+        }
+        return textures;
     }
 }
\ No newline at end of file
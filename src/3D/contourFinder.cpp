@@ -1,4 +1,6 @@
 #include <3D/contourFinder.hpp>
+#include <Profile.hpp>
+#include <Trace.hpp>
 #include <vector>
 #include <array>
 #include <set>
@@ -20,6 +22,8 @@ namespace fe{
         int alphaThreshold,
         std::vector<fe::Vec2i>& contourPoints)
     {
+        FE_PROFILE_SCOPE(FindContour);
+        FE_TRACE_SPAN("findContourMoore");
         contourPoints.clear();
         if(width <= 0 || height <= 0 || imageData.size() < static_cast<std::size_t>(width * height * 4)){
             return false;
@@ -105,6 +109,7 @@ namespace fe{
         // Continue as long as we are not back at the start point,
         // OR if we are back at the start point but haven't moved anywhere else yet.
         // Need at least 3 points for simplification/geometry generation
+        FE_PROFILE_COUNT(ContourPoints, contourPoints.size());
         return contourPoints.size() >= 3;
     }
 } // namespace fe
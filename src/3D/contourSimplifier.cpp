@@ -1,5 +1,7 @@
 #include <3D/contourSimplifier.hpp>
 #include <3D/utils.hpp>
+#include <Profile.hpp>
+#include <Trace.hpp>
 #include <vector>
 #include <cmath>
 
@@ -44,6 +46,8 @@ namespace fe{
         // will be added when the recursion unwinds and adds the 'lastIndex' point.
     }
     void simplifyContour(const std::vector<Vec2i>& points, float epsilon, std::vector<Vec2i>& result){
+        FE_PROFILE_SCOPE(SimplifyContour);
+        FE_TRACE_SPAN("simplifyContour");
         result.clear();
         if(points.size() < 3 || epsilon < 0.0f){
             result = points;
@@ -63,6 +67,7 @@ namespace fe{
                 result.pop_back();
             }
         }
+        FE_PROFILE_COUNT(SimplifiedPoints, result.size());
     }
     // This version assumes result is already populated with the start point.
     void douglasPeucker(const std::vector<Vec2i>& points, float epsilonSq, std::vector<Vec2i>& result){
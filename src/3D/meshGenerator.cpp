@@ -9,55 +9,32 @@
 #include <3D/GLTF/TextureInfo.hpp>
 #include <3D/Vec.hpp>
 #include <3D/meshGenerator.hpp>
-
-#include <EvoAI/Utils/RandomUtils.hpp>
+#include <Profile.hpp>
+#include <Trace.hpp>
+#include <Random.hpp>
+#include <RenderOptions.hpp>
+#include <ThreadPool.hpp>
 
 namespace fe{
     namespace priv{
-        struct NoiseOptions{
-            // Number of random noise points to add.
-            unsigned int numPoints{32};
-            // Minimum noise intensity (can be negative for darkening).
-            int noiseMin{-14};
-            // Maximum noise intensity
-            int noiseMax{64};
-            // Should we blend noise over a region?
-            bool softNoise{true};
-            // Radius for soft noise (in pixels) around the chosen point.
-            unsigned int spread{6};
-            // Controls how quickly the noise intensity falls off.
-            float softnessFactor{1.1};
-            // Favor stretching noise horizontally
-            float directionBiasX{0.2};
-            // Favor stretching vertically
-            float directionBiasY{0.5};
-            // Global noise multiplier
-            float scaleStrength{0.5};
-            // Frequency of variation in procedural noise
-            float frequency{0.9};
-            // Adds extra random offset to each point
-            float jitter{0.4};
-            // Controls intensity ramp (e.g. for sharpening/blooming)
-            float noisePower{0.8};
-            // Base level without noise
-            float baseHeight{0.6};
-        };
         fe::Image generateNormalFromPetal(const fe::Image& sourceImage, const NoiseOptions& options) {
+            FE_PROFILE_SCOPE(NormalMap);
+            FE_TRACE_SPAN("generateNormalFromPetal");
             sf::Vector2f sizeF = sourceImage.getSize();
             int width = static_cast<int>(sizeF.x);
             int height = static_cast<int>(sizeF.y);
             fe::Image normalMap;
             normalMap.create(width, height, sf::Color::Transparent);
-            auto sample = [&](int sx, int sy) -> float {
+            auto sample = [&](fe::Random& rng, int sx, int sy) -> float {
                 if(sourceImage.getPixel(sx, sy).a != 255){
                     return 0.f;
                 }
                 float value = options.baseHeight;
                 for(unsigned int n = 0; n < options.numPoints; ++n){
-                    int jitterX = EvoAI::randomGen().random(-options.jitter, options.jitter);
-                    int jitterY = EvoAI::randomGen().random(-options.jitter, options.jitter);
-                    int cx = sx + EvoAI::randomGen().random(-static_cast<int>(options.spread), static_cast<int>(options.spread)) + jitterX;
-                    int cy = sy + EvoAI::randomGen().random(-static_cast<int>(options.spread), static_cast<int>(options.spread)) + jitterY;
+                    int jitterX = rng.random(-options.jitter, options.jitter);
+                    int jitterY = rng.random(-options.jitter, options.jitter);
+                    int cx = sx + rng.random(-static_cast<int>(options.spread), static_cast<int>(options.spread)) + jitterX;
+                    int cy = sy + rng.random(-static_cast<int>(options.spread), static_cast<int>(options.spread)) + jitterY;
                     if(cx <= 0 || cx >= width - 1 || cy <= 0 || cy >= height - 1){
                         continue;
                     }
@@ -70,22 +47,25 @@ namespace fe{
                     if(dist > static_cast<float>(options.spread)){
                         continue;
                     }
-                    float raw = EvoAI::randomGen().random(options.noiseMin, options.noiseMax) / 255.f;
+                    float raw = rng.random(options.noiseMin, options.noiseMax) / 255.f;
                     float shaped = std::pow(std::abs(raw), options.noisePower) * (raw < 0.f ? -1.f : 1.f);
                     float falloff = options.softNoise ? std::exp(-dist * options.softnessFactor) : 1.0f;
                     value += shaped * falloff * options.scaleStrength;
                 }
                 return value;
             };
-            for(int y = 1; y < height - 1; ++y){
+            const auto numRows = static_cast<std::size_t>(std::max(height - 2, 0));
+            fe::getThreadPool().run(numRows, fe::getRenderOptions().numThreads, [&](std::size_t row){
+                const int y = static_cast<int>(row) + 1;
                 for(int x = 1; x < width - 1; ++x){
                     if(sourceImage.getPixel(x, y).a != 255){
                         continue;
                     }
-                    float hL = sample(x - 1, y);
-                    float hR = sample(x + 1, y);
-                    float hU = sample(x, y - 1);
-                    float hD = sample(x, y + 1);
+                    fe::Random rng(options.seed, static_cast<std::uint64_t>(y) * width + x);
+                    float hL = sample(rng, x - 1, y);
+                    float hR = sample(rng, x + 1, y);
+                    float hU = sample(rng, x, y - 1);
+                    float hD = sample(rng, x, y + 1);
                     fe::Vec3f normal(- (hR - hL), - (hD - hU), 1.f);
                     normal /= normal.length();
                     auto r = static_cast<sf::Uint8>((normal.x * 0.5f + 0.5f) * 255);
@@ -93,7 +73,7 @@ namespace fe{
                     auto b = static_cast<sf::Uint8>((normal.z * 0.5f + 0.5f) * 255);
                     normalMap.setPixel(x, y, sf::Color(r, g, b));
                 }
-            }
+            });
             return normalMap;
         }
         struct EmissiveOptions{
@@ -416,6 +396,7 @@ namespace fe{
     }
     void generatePistil(fe::gltf::Scene& scene, const fe::Vec3f& position, const fe::FlowerParameters& params, 
                         int pistil_filament_mat_idx, int pistil_stigma_max_idx, int pistilID){
+        FE_TRACE_SPAN_ARG("generatePistil", "pistil", pistilID);
         fe::gltf::Mesh& pistilMesh = scene.createMeshPart("Pistil_Style_Mesh_" + std::to_string(pistilID));
         auto pistilFilamentNodeIndex = scene.addNode(fe::gltf::Node::makeNode("Pistil_Style_Node_" + std::to_string(pistilID), pistilMesh));
         pistilMesh.materialIndex = pistil_filament_mat_idx;
@@ -492,6 +473,7 @@ namespace fe{
     }
 	void generateStamen(fe::gltf::Scene& scene, const fe::Vec3f& position, const fe::FlowerParameters& params, 
                         int stamen_filament_mat_idx, int stamen_anther_mat_idx, int stamenID){
+        FE_TRACE_SPAN_ARG("generateStamen", "stamen", stamenID);
 		fe::gltf::Mesh& stamenFilamentMesh = scene.createMeshPart("Stamen_Filament_Mesh_" + std::to_string(stamenID));
         auto stamenFilamentNodeIndex = scene.addNode(fe::gltf::Node::makeNode("Stamen_Filament_Node_" + std::to_string(stamenID), stamenFilamentMesh));
 		stamenFilamentMesh.materialIndex = stamen_filament_mat_idx;
@@ -599,6 +581,7 @@ namespace fe{
 		);
 	}
     void generateStem(fe::gltf::Scene& scene, const fe::FlowerParameters& params, int stemMaterialIndex){
+        FE_TRACE_SPAN("generateStem");
         if(params.stemSegments < 3){
             return;
         }
@@ -625,6 +608,8 @@ namespace fe{
         const std::vector<fe::Vec2i>& simplifiedContour,
         const fe::Image& petalLayerTexture, int layerIndex,
         const fe::Vec3f& position, const fe::FlowerParameters& params){
+        FE_PROFILE_SCOPE(PetalLayer);
+        FE_TRACE_SPAN_ARG("generatePetalLayer", "layer", layerIndex);
         const auto numPoints = simplifiedContour.size();
         const auto imgWidth = petalLayerTexture.getSize().x;
         const auto imgHeight = petalLayerTexture.getSize().y;
@@ -632,15 +617,20 @@ namespace fe{
         if(numPoints < 3 || imgWidth <= 0 || imgHeight <= 0){
             return;
         }
-        // Create Texture and Material for this Petal Layer
+        // Create Textures and Material for this Petal Layer
         std::string textureName = "Petal_Layer_Texture_" + std::to_string(layerIndex);
-        int textureIndex = scene.addTexture(fe::gltf::TextureInfo::createFromImage(textureName, petalLayerTexture));
         std::string materialName = "Petal_Layer_Material_" + std::to_string(layerIndex);
-        int normalIndex = -1;
-        int emissiveIndex = -1;
+        fe::Image noiseImage;
+        fe::Image emissiveImage;
+        auto emissiveOpts = priv::EmissiveOptions{
+            .colorThreshold = 0.8f,
+            .minIntensity = 0.01f,
+            .maxIntensity = 1.5f,
+            .falloffPower = 1.2f
+        };
+        std::vector<std::pair<std::string, const fe::Image*>> images{{textureName, &petalLayerTexture}};
         if(params.useNormals){
-            std::string normalName = "Petal_Layer_Normal_" + std::to_string(layerIndex);
-            auto noiseImage = priv::generateNormalFromPetal(petalLayerTexture, 
+            noiseImage = priv::generateNormalFromPetal(petalLayerTexture, 
                 {
                     .numPoints = 32,
                     .noiseMin = -14, 
@@ -655,11 +645,20 @@ namespace fe{
                     .jitter = 0.4,
                     .noisePower = 0.8,
                     .baseHeight = 0.8,
+                    .seed = fe::getRandom(fe::RandomStream::NormalMap, layerIndex).next(),
                 }
             );
-            auto normTex = fe::gltf::TextureInfo::createFromImage(normalName, noiseImage);
-            normalIndex = scene.addTexture(normTex);
+            images.emplace_back("Petal_Layer_Normal_" + std::to_string(layerIndex), &noiseImage);
         }
+        if(params.useEmissive){
+            emissiveImage = priv::generateEmissiveFromPetal(petalLayerTexture, emissiveOpts);
+            images.emplace_back("Petal_Layer_Emissive_" + std::to_string(layerIndex), &emissiveImage);
+        }
+        // the png encodes of the layer run in parallel, the textures are added in the same order as before
+        auto textures = fe::gltf::TextureInfo::createFromImages(images);
+        int textureIndex = scene.addTexture(textures[0]);
+        int normalIndex = params.useNormals ? scene.addTexture(textures[1]):-1;
+        int emissiveIndex = params.useEmissive ? scene.addTexture(textures.back()):-1;
         std::string meshPartName = "Petal_Layer_Mesh_" + std::to_string(layerIndex);
         auto& petalMesh = scene.createMeshPart(meshPartName);
         auto petalNode = fe::gltf::Node::makeNode("Petal_Layer_Node_" + std::to_string(layerIndex), petalMesh);
@@ -672,15 +671,7 @@ namespace fe{
         const double d_petalDroopFactor = static_cast<double>(params.petalDroopFactor);
         const double d_base_y = static_cast<double>(position.y);
         if(params.useEmissive){
-            auto opts = priv::EmissiveOptions{
-                .colorThreshold = 0.8f,
-                .minIntensity = 0.01f,
-                .maxIntensity = 1.5f,
-                .falloffPower = 1.2f
-            };
-            auto emissiveImage = priv::generateEmissiveFromPetal(petalLayerTexture, opts);
-            auto emissiveTex = fe::gltf::TextureInfo::createFromImage("Petal_Layer_Emissive_" + std::to_string(layerIndex), emissiveImage);
-            emissiveIndex = scene.addTexture(emissiveTex);
+            const auto& opts = emissiveOpts;
             JsonBox::Object extra;
             JsonBox::Array lights;
             float cx = imgWidth * 0.5f;
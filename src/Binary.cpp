@@ -0,0 +1,281 @@
+#include <Binary.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+namespace fe{
+	namespace binary{
+		namespace{
+			constexpr std::uint8_t magic[] = {'F', 'E', 'B'};
+			/// nested arrays and objects decode accepts.
+			constexpr int maxDepth = 64;
+			void collectKeys(const JsonBox::Value& v, std::map<std::string, std::uint64_t>& keys){
+				if(v.isObject()){
+					for(const auto& [key, value]:v.getObject()){
+						keys.emplace(key, 0);
+						collectKeys(value, keys);
+					}
+				}else if(v.isArray()){
+					for(const auto& value:v.getArray()){
+						collectKeys(value, keys);
+					}
+				}
+			}
+			class Writer final{
+				public:
+					explicit Writer(std::vector<std::uint8_t>& out) noexcept
+					: m_out(out){}
+					void byte(std::uint8_t b){
+						m_out.emplace_back(b);
+					}
+					void varint(std::uint64_t value){
+						while(value >= 0x80){
+							byte(static_cast<std::uint8_t>(value | 0x80));
+							value >>= 7;
+						}
+						byte(static_cast<std::uint8_t>(value));
+					}
+					void bytes(const std::string& s){
+						varint(s.size());
+						m_out.insert(std::end(m_out), std::begin(s), std::end(s));
+					}
+					void littleEndian(std::uint64_t bits, int numBytes){
+						for(auto i=0;i<numBytes;++i){
+							byte(static_cast<std::uint8_t>(bits >> (8 * i)));
+						}
+					}
+					void value(const JsonBox::Value& v, const std::map<std::string, std::uint64_t>& keys){
+						switch(v.getType()){
+							case JsonBox::Value::BOOLEAN:
+								byte(static_cast<std::uint8_t>(v.getBoolean() ? Tag::True:Tag::False));
+								break;
+							case JsonBox::Value::INTEGER:
+								{
+									const auto i = static_cast<std::int64_t>(v.getInteger());
+									byte(static_cast<std::uint8_t>(Tag::Integer));
+									varint((static_cast<std::uint64_t>(i) << 1) ^ static_cast<std::uint64_t>(i >> 63));
+								}break;
+							case JsonBox::Value::DOUBLE:
+								{
+									const auto d = v.getDouble();
+									// converting a double out of the float range is undefined.
+									const bool isFloat = std::abs(d) <= std::numeric_limits<float>::max()
+										&& static_cast<double>(static_cast<float>(d)) == d;
+									if(isFloat){
+										const auto f = static_cast<float>(d);
+										std::uint32_t bits;
+										std::memcpy(&bits, &f, sizeof(bits));
+										byte(static_cast<std::uint8_t>(Tag::Float));
+										littleEndian(bits, 4);
+									}else{
+										std::uint64_t bits;
+										std::memcpy(&bits, &d, sizeof(bits));
+										byte(static_cast<std::uint8_t>(Tag::Double));
+										littleEndian(bits, 8);
+									}
+								}break;
+							case JsonBox::Value::STRING:
+								byte(static_cast<std::uint8_t>(Tag::String));
+								bytes(v.getString());
+								break;
+							case JsonBox::Value::ARRAY:
+								byte(static_cast<std::uint8_t>(Tag::Array));
+								varint(v.getArray().size());
+								for(const auto& element:v.getArray()){
+									value(element, keys);
+								}
+								break;
+							case JsonBox::Value::OBJECT:
+								byte(static_cast<std::uint8_t>(Tag::Object));
+								varint(v.getObject().size());
+								for(const auto& [key, element]:v.getObject()){
+									varint(keys.at(key));
+									value(element, keys);
+								}
+								break;
+							default:
+								byte(static_cast<std::uint8_t>(Tag::Null));
+								break;
+						}
+					}
+				private:
+					std::vector<std::uint8_t>& m_out;
+			};
+			class Reader final{
+				public:
+					Reader(const std::uint8_t* data, std::size_t size) noexcept
+					: m_data(data)
+					, m_size(size)
+					, m_pos(0)
+					, m_keys(){}
+					void header(){
+						if(!isBinary(m_data, m_size) || m_size < sizeof(magic) + 1){
+							fail("not a binary flower");
+						}
+						m_pos = sizeof(magic);
+						if(byte() > version){
+							fail("binary flower from a newer version");
+						}
+						const auto numKeys = count();
+						m_keys.reserve(numKeys);
+						for(auto i=0u;i<numKeys;++i){
+							m_keys.emplace_back(string());
+						}
+					}
+					/**
+					 *  @brief decodes the next value into v, it fills arrays and objects in place so nothing is copied.
+					 */
+					void value(JsonBox::Value& v, int depth){
+						if(depth > maxDepth){
+							fail("binary flower is nested too deep");
+						}
+						switch(static_cast<Tag>(byte())){
+							case Tag::Null:
+								v.setNull();
+								break;
+							case Tag::False:
+								v.setBoolean(false);
+								break;
+							case Tag::True:
+								v.setBoolean(true);
+								break;
+							case Tag::Integer:
+								{
+									const auto zigzag = varint();
+									const auto i = static_cast<std::int64_t>(zigzag >> 1) ^ -static_cast<std::int64_t>(zigzag & 1);
+									if(i < std::numeric_limits<int>::min() || i > std::numeric_limits<int>::max()){
+										fail("integer out of range in binary flower");
+									}
+									v.setInteger(static_cast<int>(i));
+								}break;
+							case Tag::Float:
+								{
+									const auto bits = static_cast<std::uint32_t>(littleEndian(4));
+									float f;
+									std::memcpy(&f, &bits, sizeof(f));
+									v.setDouble(static_cast<double>(f));
+								}break;
+							case Tag::Double:
+								{
+									const auto bits = littleEndian(8);
+									double d;
+									std::memcpy(&d, &bits, sizeof(d));
+									v.setDouble(d);
+								}break;
+							case Tag::String:
+								v.setString(string());
+								break;
+							case Tag::Array:
+								{
+									const auto numValues = count();
+									v.setArray(JsonBox::Array());
+									auto& a = v.getArray();
+									a.resize(numValues);
+									for(auto& element:a){
+										value(element, depth + 1);
+									}
+								}break;
+							case Tag::Object:
+								{
+									const auto numValues = count();
+									v.setObject(JsonBox::Object());
+									auto& o = v.getObject();
+									for(auto i=0u;i<numValues;++i){
+										const auto key = varint();
+										if(key >= m_keys.size()){
+											fail("invalid key in binary flower");
+										}
+										value(o[m_keys[key]], depth + 1);
+									}
+								}break;
+							default:
+								fail("invalid tag in binary flower");
+						}
+					}
+					bool atEnd() const noexcept{
+						return m_pos == m_size;
+					}
+				private:
+					[[noreturn]] void fail(const std::string& msg) const{
+						throw std::invalid_argument("error, " + msg + " (byte " + std::to_string(m_pos) + ").");
+					}
+					std::uint8_t byte(){
+						if(m_pos >= m_size){
+							fail("truncated binary flower");
+						}
+						return m_data[m_pos++];
+					}
+					std::uint64_t varint(){
+						std::uint64_t value = 0;
+						for(auto shift=0;shift<64;shift+=7){
+							const auto b = byte();
+							value |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+							if(!(b & 0x80)){
+								return value;
+							}
+						}
+						fail("invalid varint in binary flower");
+					}
+					/**
+					 *  @brief a count of values, every value takes at least a byte so it can't be more than what is left.
+					 */
+					std::size_t count(){
+						const auto n = varint();
+						if(n > m_size - m_pos){
+							fail("truncated binary flower");
+						}
+						return static_cast<std::size_t>(n);
+					}
+					std::uint64_t littleEndian(int numBytes){
+						std::uint64_t bits = 0;
+						for(auto i=0;i<numBytes;++i){
+							bits |= static_cast<std::uint64_t>(byte()) << (8 * i);
+						}
+						return bits;
+					}
+					std::string string(){
+						const auto length = count();
+						std::string s(reinterpret_cast<const char*>(m_data + m_pos), length);
+						m_pos += length;
+						return s;
+					}
+					const std::uint8_t* m_data;
+					std::size_t m_size;
+					std::size_t m_pos;
+					std::vector<std::string> m_keys;
+			};
+		} // namespace
+		std::vector<std::uint8_t> encode(const JsonBox::Value& v){
+			std::map<std::string, std::uint64_t> keys;
+			collectKeys(v, keys);
+			std::vector<std::uint8_t> out(std::begin(magic), std::end(magic));
+			Writer writer(out);
+			writer.byte(version);
+			writer.varint(keys.size());
+			std::uint64_t index = 0;
+			for(auto& [key, i]:keys){
+				writer.bytes(key);
+				i = index++;
+			}
+			writer.value(v, keys);
+			return out;
+		}
+		JsonBox::Value decode(const std::uint8_t* data, std::size_t size){
+			Reader reader(data, size);
+			reader.header();
+			JsonBox::Value v;
+			reader.value(v, 0);
+			if(!reader.atEnd()){
+				throw std::invalid_argument("error, trailing bytes after the binary flower.");
+			}
+			return v;
+		}
+		bool isBinary(const std::uint8_t* data, std::size_t size) noexcept{
+			return size >= sizeof(magic) && std::memcmp(data, magic, sizeof(magic)) == 0;
+		}
+	} // namespace binary
+} // namespace fe
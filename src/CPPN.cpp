@@ -0,0 +1,413 @@
+#include <CPPN.hpp>
+#include <GenomeHash.hpp>
+#include <Platform.hpp>
+#include <Profile.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#if defined(__wasm_simd128__)
+	#include <wasm_simd128.h>
+#endif
+
+namespace fe{
+	namespace{
+		/// inputs used to check the tape against EvoAI::NeuralNetwork::forward, they cover
+		/// the ranges of radius, sin(P*angle), layer and bias that Petals and Stats use.
+		constexpr double probes[][4] = {
+			{0.0, 0.0, 0.0, 1.0},
+			{1.0, -1.0, 2.0, 1.0},
+			{37.0, 0.5, 3.0, 0.5},
+			{-0.75, 0.25, -5.0, 2.0},
+			{256.0, -0.9, 8.0, 1.0}
+		};
+		/// relative, it allows a different summation order
+		constexpr double probeTolerance = 1e-9;
+		/**
+		 *  @brief acc[i] += src[i] * weight for count values.
+		 */
+		void accumulate(double* acc, const double* src, double weight, std::size_t count) noexcept{
+			std::size_t i = 0;
+#if defined(__wasm_simd128__)
+			const auto w = wasm_f64x2_splat(weight);
+			for(;i+2<=count;i+=2){
+				const auto a = wasm_v128_load(acc + i);
+				const auto v = wasm_v128_load(src + i);
+				wasm_v128_store(acc + i, wasm_f64x2_add(a, wasm_f64x2_mul(v, w)));
+			}
+#endif
+			for(;i<count;++i){
+				acc[i] += src[i] * weight;
+			}
+		}
+		/**
+		 *  @brief least recently used cache of CPPN limited by memory.
+		 */
+		struct CPPNCache final{
+			struct Entry{
+				GenomeHash hash;
+				std::shared_ptr<const CPPN> cppn;
+				std::size_t bytes;
+				std::uint64_t lastUse;
+			};
+			std::mutex mutex;
+			std::vector<Entry> entries;
+			std::size_t bytes{0};
+			/// 1/32 of the heap (640 KB of the 20 MB wasm heap), 4 MB natively
+			std::size_t limit{platform::getCacheBudget(32, 4 * 1024 * 1024)};
+			std::uint64_t clock{0};
+			/**
+			 *  @brief evicts least recently used CPPN until extra bytes fit in the limit.
+			 */
+			void evict(std::size_t extra) noexcept{
+				while(!entries.empty() && bytes + extra > limit){
+					auto lru = std::min_element(std::begin(entries), std::end(entries), [](const Entry& a, const Entry& b){
+						return a.lastUse < b.lastUse;
+					});
+					bytes -= lru->bytes;
+					entries.erase(lru);
+				}
+			}
+			void add(const GenomeHash& hash, const std::shared_ptr<const CPPN>& cppn) noexcept{
+				auto it = std::find_if(std::begin(entries), std::end(entries), [hash](const Entry& e){
+					return e.hash == hash;
+				});
+				if(it != std::end(entries)){
+					return;
+				}
+				const auto cppnBytes = cppn->getSizeInBytes();
+				if(cppnBytes > limit){
+					return;
+				}
+				evict(cppnBytes);
+				entries.push_back({hash, cppn, cppnBytes, ++clock});
+				bytes += cppnBytes;
+			}
+		};
+		CPPNCache& cppnCache() noexcept{
+			static CPPNCache cache;
+			return cache;
+		}
+	} // namespace
+	CPPN::CPPN(const EvoAI::Genome& g) noexcept
+	: m_tape()
+	, m_inputs()
+	, m_outputs()
+	, m_numNodes(0)
+	, m_numInputs(0)
+	, m_numOutputs(0)
+	, m_nn(EvoAI::Genome::makePhenotype(g))
+	, m_phenotypeBytes(0){
+		if(compile(*m_nn) && matches(*m_nn)){
+			m_nn.reset();
+		}else{
+			m_tape.clear();
+			m_inputs.clear();
+			m_phenotypeBytes = sizeof(EvoAI::NeuralNetwork)
+								+ g.getNodeChromosomes().size() * sizeof(EvoAI::Neuron)
+								+ g.getConnectionChromosomes().size() * sizeof(EvoAI::Connection);
+		}
+	}
+	bool CPPN::isCompiled() const noexcept{
+		return !m_nn.has_value();
+	}
+	std::size_t CPPN::getNumInputs() const noexcept{
+		return m_numInputs;
+	}
+	std::size_t CPPN::getNumOutputs() const noexcept{
+		return m_numOutputs;
+	}
+	std::size_t CPPN::getNumNodes() const noexcept{
+		return m_numNodes;
+	}
+	void CPPN::evaluate(const double* inputs, double* outputs, double* values) const noexcept{
+		std::copy(inputs, inputs + m_numInputs, values);
+		const auto* in = m_inputs.data();
+		for(const auto& ins:m_tape){
+			auto sum = 0.0;
+			const auto* first = in + ins.firstInput;
+			for(auto i=0u;i<ins.numInputs;++i){
+				sum += values[first[i].node] * first[i].weight;
+			}
+			values[ins.node] = priv::activate(ins.activation, sum + ins.bias);
+		}
+		for(auto i=0u;i<m_numOutputs;++i){
+			outputs[i] = values[m_outputs[i]];
+		}
+	}
+	void CPPN::evaluateBatch(const double* const* inputs, double* const* outputs, std::size_t count, double* values) const noexcept{
+		count = std::min(count, batchSize);
+		for(auto i=0u;i<m_numInputs;++i){
+			std::copy(inputs[i], inputs[i] + count, values + i * batchSize);
+		}
+		const auto* in = m_inputs.data();
+		for(const auto& ins:m_tape){
+			auto* acc = values + ins.node * batchSize;
+			std::fill(acc, acc + count, 0.0);
+			const auto* first = in + ins.firstInput;
+			for(auto i=0u;i<ins.numInputs;++i){
+				accumulate(acc, values + first[i].node * batchSize, first[i].weight, count);
+			}
+			priv::activateBatch(ins.activation, acc, ins.bias, count);
+		}
+		for(auto i=0u;i<m_numOutputs;++i){
+			const auto* out = values + m_outputs[i] * batchSize;
+			std::copy(out, out + count, outputs[i]);
+		}
+	}
+	void CPPN::forwardBatch(const double* const* inputs, double* const* outputs, std::size_t count) const noexcept{
+		if(!isCompiled()){
+			std::vector<double> in(m_numInputs);
+			std::vector<double> out(m_numOutputs);
+			for(auto k=0u;k<count;++k){
+				for(auto i=0u;i<m_numInputs;++i){
+					in[i] = inputs[i][k];
+				}
+				forward(in.data(), out.data());
+				for(auto i=0u;i<m_numOutputs;++i){
+					outputs[i][k] = out[i];
+				}
+			}
+			return;
+		}
+		// the CPPN is shared, every thread has its own scratch.
+		thread_local std::vector<double> values;
+		thread_local std::vector<const double*> batchInputs;
+		thread_local std::vector<double*> batchOutputs;
+		values.resize(m_numNodes * batchSize);
+		batchInputs.resize(m_numInputs);
+		batchOutputs.resize(m_numOutputs);
+		for(std::size_t start=0;start<count;start+=batchSize){
+			for(auto i=0u;i<m_numInputs;++i){
+				batchInputs[i] = inputs[i] + start;
+			}
+			for(auto i=0u;i<m_numOutputs;++i){
+				batchOutputs[i] = outputs[i] + start;
+			}
+			evaluateBatch(batchInputs.data(), batchOutputs.data(), std::min(batchSize, count - start), values.data());
+		}
+	}
+	void CPPN::forward(const double* inputs, double* outputs) const noexcept{
+		if(isCompiled()){
+			thread_local std::vector<double> values;
+			values.resize(m_numNodes);
+			evaluate(inputs, outputs, values.data());
+			return;
+		}
+		std::lock_guard lock(m_nnMutex);
+		auto res = m_nn->forward(std::vector<double>(inputs, inputs + m_numInputs));
+		m_nn->reset();
+		for(auto i=0u;i<m_numOutputs;++i){
+			outputs[i] = i < res.size() ? res[i]:0.0;
+		}
+	}
+	const std::vector<CPPN::Instruction>& CPPN::getTape() const noexcept{
+		return m_tape;
+	}
+	const std::vector<CPPN::Input>& CPPN::getInputs() const noexcept{
+		return m_inputs;
+	}
+	const std::vector<std::uint32_t>& CPPN::getOutputs() const noexcept{
+		return m_outputs;
+	}
+	std::size_t CPPN::getSizeInBytes() const noexcept{
+		return sizeof(CPPN)
+			+ m_tape.capacity() * sizeof(Instruction)
+			+ m_inputs.capacity() * sizeof(Input)
+			+ m_outputs.capacity() * sizeof(std::uint32_t)
+			+ m_phenotypeBytes;
+	}
+	bool CPPN::compile(EvoAI::NeuralNetwork& nn) noexcept{
+		if(nn.size() < 2){
+			return false;
+		}
+		// node index in evaluation order for each (layer, neuron)
+		std::vector<std::vector<std::uint32_t>> order(nn.size());
+		std::uint32_t numNodes = 0;
+		for(auto l=0u;l<nn.size();++l){
+			for(auto n=0u;n<nn[l].size();++n){
+				order[l].emplace_back(numNodes++);
+			}
+		}
+		m_numInputs = nn[0].size();
+		m_numOutputs = nn[nn.size()-1].size();
+		m_numNodes = numNodes;
+		// inputs grouped by destination node
+		std::vector<std::vector<Input>> incoming(numNodes);
+		for(auto l=0u;l<nn.size();++l){
+			const auto& neurons = nn[l].getNeurons();
+			for(auto n=0u;n<neurons.size();++n){
+				const auto& neuron = neurons[n];
+				const auto src = order[l][n];
+				const bool isInput = neuron.getType() == EvoAI::Neuron::Type::INPUT;
+				if(isInput != (l == 0) || neuron.getType() == EvoAI::Neuron::Type::CONTEXT){
+					return false;
+				}
+				for(const auto& c:neuron.getConnections()){
+					const auto& dest = c.getDest();
+					if(dest.layer >= order.size() || dest.neuron >= order[dest.layer].size()){
+						return false;
+					}
+					const auto dst = order[dest.layer][dest.neuron];
+					// the destination was already activated, after nn.reset() it doesn't change the outputs.
+					if(dst <= src){
+						continue;
+					}
+					incoming[dst].push_back({src, c.getWeight()});
+				}
+			}
+		}
+		for(auto l=1u;l<nn.size();++l){
+			const auto& neurons = nn[l].getNeurons();
+			for(auto n=0u;n<neurons.size();++n){
+				Instruction ins;
+				if(!priv::toTapeActivation(neurons[n].getActivationType(), ins.activation)){
+					return false;
+				}
+				ins.node = order[l][n];
+				ins.firstInput = static_cast<std::uint32_t>(m_inputs.size());
+				ins.numInputs = static_cast<std::uint32_t>(incoming[ins.node].size());
+				ins.bias = nn[l].getBias() * neurons[n].getBiasWeight();
+				m_inputs.insert(std::end(m_inputs), std::begin(incoming[ins.node]), std::end(incoming[ins.node]));
+				m_tape.emplace_back(ins);
+			}
+		}
+		m_outputs = order.back();
+		return true;
+	}
+	bool CPPN::matches(EvoAI::NeuralNetwork& nn) noexcept{
+		std::vector<double> in(m_numInputs);
+		std::vector<double> out(m_numOutputs);
+		std::vector<double> values(m_numNodes);
+		for(const auto& probe:probes){
+			for(auto i=0u;i<m_numInputs;++i){
+				in[i] = probe[i % 4];
+			}
+			evaluate(in.data(), out.data(), values.data());
+			auto expected = nn.forward(in);
+			nn.reset();
+			if(expected.size() != m_numOutputs){
+				return false;
+			}
+			for(auto i=0u;i<m_numOutputs;++i){
+				const auto e = expected[i];
+				const bool same = out[i] == e || (std::isnan(e) && std::isnan(out[i]));
+				if(!same && !(std::abs(out[i] - e) <= probeTolerance * std::max(1.0, std::abs(e)))){
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+	std::shared_ptr<const CPPN> getCPPN(const EvoAI::Genome& g) noexcept{
+		const auto hash = hashGenome(g, 0.0);
+		auto& cache = cppnCache();
+		{
+			std::lock_guard lock(cache.mutex);
+			auto it = std::find_if(std::begin(cache.entries), std::end(cache.entries), [hash](const auto& e){
+				return e.hash == hash;
+			});
+			if(it != std::end(cache.entries)){
+				it->lastUse = ++cache.clock;
+				FE_PROFILE_COUNT(CPPNCacheHits, 1);
+				return it->cppn;
+			}
+		}
+		FE_PROFILE_COUNT(CPPNCacheMisses, 1);
+		auto cppn = std::make_shared<CPPN>(g);
+		std::lock_guard lock(cache.mutex);
+		cache.add(hash, cppn);
+		return cppn;
+	}
+	void setCPPNCacheLimit(std::size_t bytes) noexcept{
+		auto& cache = cppnCache();
+		std::lock_guard lock(cache.mutex);
+		cache.limit = bytes;
+		cache.evict(0);
+	}
+	void clearCPPNCache() noexcept{
+		auto& cache = cppnCache();
+		std::lock_guard lock(cache.mutex);
+		cache.entries.clear();
+		cache.bytes = 0;
+	}
+	namespace priv{
+		bool toTapeActivation(EvoAI::Neuron::ActivationType type, CPPN::Activation& act) noexcept{
+			using Type = EvoAI::Neuron::ActivationType;
+			switch(type){
+				case Type::IDENTITY:			act = CPPN::Activation::Identity;			return true;
+				case Type::SIGMOID:				act = CPPN::Activation::Sigmoid;			return true;
+				case Type::STEEPENED_SIGMOID:	act = CPPN::Activation::SteepenedSigmoid;	return true;
+				case Type::SWISH:				act = CPPN::Activation::Swish;				return true;
+				case Type::TANH:				act = CPPN::Activation::Tanh;				return true;
+				case Type::SINUSOID:			act = CPPN::Activation::Sinusoid;			return true;
+				case Type::COSINE:				act = CPPN::Activation::Cosine;				return true;
+				case Type::TAN:					act = CPPN::Activation::Tan;				return true;
+				case Type::RELU:				act = CPPN::Activation::Relu;				return true;
+				case Type::GAUSSIAN:			act = CPPN::Activation::Gaussian;			return true;
+				case Type::SQUARE:				act = CPPN::Activation::Square;				return true;
+				case Type::CUBE:				act = CPPN::Activation::Cube;				return true;
+				case Type::SOFTPLUS:			act = CPPN::Activation::Softplus;			return true;
+				case Type::CLAMP:				act = CPPN::Activation::Clamp;				return true;
+				case Type::ABS:					act = CPPN::Activation::Abs;				return true;
+				case Type::EXP:					act = CPPN::Activation::Exp;				return true;
+				case Type::HAT:					act = CPPN::Activation::Hat;				return true;
+				default:
+					return false;
+			}
+		}
+		double activate(CPPN::Activation act, double x) noexcept{
+			switch(act){
+				case CPPN::Activation::Identity:			return x;
+				case CPPN::Activation::Sigmoid:				return 1.0 / (1.0 + std::exp(-x));
+				case CPPN::Activation::SteepenedSigmoid:	return 1.0 / (1.0 + std::exp(-4.9 * x));
+				case CPPN::Activation::Swish:				return x / (1.0 + std::exp(-x));
+				case CPPN::Activation::Tanh:				return std::tanh(x);
+				case CPPN::Activation::Sinusoid:			return std::sin(x);
+				case CPPN::Activation::Cosine:				return std::cos(x);
+				case CPPN::Activation::Tan:					return std::tan(x);
+				case CPPN::Activation::Relu:				return x > 0.0 ? x:0.0;
+				case CPPN::Activation::Gaussian:			return std::exp(-(x * x) / 2.0);
+				case CPPN::Activation::Square:				return x * x;
+				case CPPN::Activation::Cube:				return x * x * x;
+				case CPPN::Activation::Softplus:			return std::log(1.0 + std::exp(x));
+				case CPPN::Activation::Clamp:				return std::clamp(x, -1.0, 1.0);
+				case CPPN::Activation::Abs:					return std::abs(x);
+				case CPPN::Activation::Exp:					return std::exp(x);
+				case CPPN::Activation::Hat:					return std::max(0.0, 1.0 - std::abs(x));
+			}
+			return x;
+		}
+		void activateBatch(CPPN::Activation act, double* values, double bias, std::size_t count) noexcept{
+			std::size_t i = 0;
+#if defined(__wasm_simd128__)
+			// only the ones that give the same results as activate, pmin / pmax are (b < a ? b:a) / (a < b ? b:a) like std::min / std::max
+			const auto b = wasm_f64x2_splat(bias);
+			const auto zero = wasm_f64x2_splat(0.0);
+			const auto one = wasm_f64x2_splat(1.0);
+			const auto minusOne = wasm_f64x2_splat(-1.0);
+			for(;i+2<=count;i+=2){
+				const auto x = wasm_f64x2_add(wasm_v128_load(values + i), b);
+				v128_t r;
+				switch(act){
+					case CPPN::Activation::Identity:	r = x;																	break;
+					case CPPN::Activation::Relu:		r = wasm_v128_and(x, wasm_f64x2_gt(x, zero));							break;
+					case CPPN::Activation::Square:		r = wasm_f64x2_mul(x, x);												break;
+					case CPPN::Activation::Cube:		r = wasm_f64x2_mul(wasm_f64x2_mul(x, x), x);							break;
+					case CPPN::Activation::Clamp:		r = wasm_f64x2_pmin(wasm_f64x2_pmax(x, minusOne), one);					break;
+					case CPPN::Activation::Abs:			r = wasm_f64x2_abs(x);													break;
+					case CPPN::Activation::Hat:			r = wasm_f64x2_pmax(zero, wasm_f64x2_sub(one, wasm_f64x2_abs(x)));		break;
+					default:
+						r = wasm_f64x2_make(activate(act, wasm_f64x2_extract_lane(x, 0)), activate(act, wasm_f64x2_extract_lane(x, 1)));
+						break;
+				}
+				wasm_v128_store(values + i, r);
+			}
+#endif
+			for(;i<count;++i){
+				values[i] = activate(act, values[i] + bias);
+			}
+		}
+	} // namespace priv
+} // namespace fe
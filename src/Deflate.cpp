@@ -0,0 +1,665 @@
+#include <Deflate.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+namespace fe{
+	namespace deflate{
+		namespace{
+			constexpr int minMatch = 3;
+			constexpr int maxMatch = 258;
+			constexpr std::size_t windowSize = 32768;
+			constexpr int hashBits = 15;
+			constexpr std::size_t hashSize = std::size_t{1} << hashBits;
+			/// tokens of a block, a block is written when it has this many.
+			constexpr std::size_t maxTokens = 1 << 15;
+			/// bytes of a stored block.
+			constexpr std::size_t maxStored = 65535;
+			constexpr int numLitLen = 286;
+			constexpr int numDist = 30;
+			constexpr int numCodeLengths = 19;
+			constexpr int maxBits = 15;
+			constexpr int maxCodeLengthBits = 7;
+			constexpr int endOfBlock = 256;
+			constexpr std::array<std::uint16_t, 29> lengthBase{3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+															   35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+			constexpr std::array<std::uint8_t, 29> lengthExtra{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+															   3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+			constexpr std::array<std::uint16_t, 30> distBase{1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+															 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+			constexpr std::array<std::uint8_t, 30> distExtra{0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+															 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+			constexpr std::array<std::uint8_t, numCodeLengths> codeLengthOrder{16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+			/**
+			 *  @brief chain is how many candidates are tried (a quarter once there is a match of good length),
+			 *  nice stops at a match that long, lazy levels try the next position before taking a match shorter
+			 *  than maxLazy and greedy levels only hash the positions inside matches up to maxLazy long (like zlib).
+			 */
+			struct Level final{
+				int good;
+				int maxLazy;
+				int nice;
+				int chain;
+				bool lazy;
+			};
+			constexpr std::array<Level, 10> levels{{
+				{0, 0, 0, 0, false},
+				{4, 4, 8, 4, false},
+				{4, 5, 16, 8, false},
+				{4, 6, 32, 32, false},
+				{4, 4, 16, 16, true},
+				{8, 16, 32, 32, true},
+				{8, 16, 128, 128, true},
+				{8, 32, 128, 256, true},
+				{32, 128, maxMatch, 1024, true},
+				{32, maxMatch, maxMatch, 4096, true}
+			}};
+			struct Tables final{
+				Tables() noexcept{
+					for(auto code=0u;code<lengthBase.size();++code){
+						for(auto len=lengthBase[code];len<lengthBase[code] + (1u << lengthExtra[code]) && len <= maxMatch;++len){
+							lengthCode[len] = static_cast<std::uint8_t>(code);
+						}
+					}
+					// the last code is only 258, 227 + 31 would overwrite it
+					lengthCode[maxMatch] = static_cast<std::uint8_t>(lengthBase.size() - 1);
+					for(auto code=0u;code<distBase.size();++code){
+						for(auto d=distBase[code];d<distBase[code] + (1u << distExtra[code]);++d){
+							if(d <= 256){
+								distCode[d - 1] = static_cast<std::uint8_t>(code);
+							}else{
+								distCode[256 + ((d - 1) >> 7)] = static_cast<std::uint8_t>(code);
+							}
+						}
+					}
+					for(auto n=0u;n<256;++n){
+						auto c = n;
+						for(auto k=0;k<8;++k){
+							c = c & 1 ? 0xEDB88320u ^ (c >> 1):c >> 1;
+						}
+						crc[n] = c;
+					}
+					for(auto i=0;i<288;++i){
+						fixedLitLen[i] = i < 144 ? 8:i < 256 ? 9:i < 280 ? 7:8;
+					}
+					fixedDist.fill(5);
+				}
+				std::uint8_t getDistCode(std::uint32_t dist) const noexcept{
+					return dist <= 256 ? distCode[dist - 1]:distCode[256 + ((dist - 1) >> 7)];
+				}
+				std::array<std::uint8_t, maxMatch + 1> lengthCode{};
+				std::array<std::uint8_t, 512> distCode{};
+				std::array<std::uint32_t, 256> crc{};
+				std::array<std::uint8_t, 288> fixedLitLen{};
+				std::array<std::uint8_t, 32> fixedDist{};
+			};
+			const Tables& tables() noexcept{
+				static const Tables t;
+				return t;
+			}
+			class BitWriter final{
+				public:
+					explicit BitWriter(std::uint8_t* out) noexcept
+					: m_out(out)
+					, m_pos(0)
+					, m_bits(0)
+					, m_count(0){}
+					/**
+					 *  @brief writes the n low bits of bits, n <= 32.
+					 */
+					void put(std::uint32_t bits, int n) noexcept{
+						m_bits |= static_cast<std::uint64_t>(bits) << m_count;
+						m_count += n;
+						while(m_count >= 8){
+							m_out[m_pos++] = static_cast<std::uint8_t>(m_bits);
+							m_bits >>= 8;
+							m_count -= 8;
+						}
+					}
+					void align() noexcept{
+						if(m_count > 0){
+							put(0, 8 - m_count);
+						}
+					}
+					/**
+					 *  @brief copies bytes, it has to be aligned.
+					 */
+					void bytes(const std::uint8_t* data, std::size_t size) noexcept{
+						std::memcpy(m_out + m_pos, data, size);
+						m_pos += size;
+					}
+					/**
+					 *  @brief bytes written, it has to be aligned.
+					 */
+					std::size_t size() const noexcept{
+						return m_pos;
+					}
+				private:
+					std::uint8_t* m_out;
+					std::size_t m_pos;
+					std::uint64_t m_bits;
+					int m_count;
+			};
+			/**
+			 *  @brief huffman code lengths limited to limit bits, there are at least 2 codes.
+			 */
+			void buildLengths(const std::uint32_t* freq, int numSymbols, int limit, std::uint8_t* lengths) noexcept{
+				std::fill(lengths, lengths + numSymbols, 0);
+				std::vector<int> leaves;
+				leaves.reserve(numSymbols);
+				for(auto i=0;i<numSymbols;++i){
+					if(freq[i] > 0){
+						leaves.emplace_back(i);
+					}
+				}
+				for(auto i=0;leaves.size() < 2;++i){
+					if(freq[i] == 0){
+						leaves.emplace_back(i);
+					}
+				}
+				std::stable_sort(std::begin(leaves), std::end(leaves), [freq](int a, int b){
+					return freq[a] < freq[b];
+				});
+				// two queues huffman, the leaves sorted and the inner nodes in the order they are made
+				const auto numLeaves = static_cast<int>(leaves.size());
+				const auto numNodes = 2 * numLeaves - 1;
+				std::vector<std::uint64_t> weight(numNodes);
+				std::vector<int> parent(numNodes, 0);
+				for(auto i=0;i<numLeaves;++i){
+					weight[i] = std::max<std::uint32_t>(freq[leaves[i]], 1);
+				}
+				auto leaf = 0;
+				auto inner = numLeaves;
+				auto smallest = [&](int next){
+					if(leaf < numLeaves && (inner >= next || weight[leaf] <= weight[inner])){
+						return leaf++;
+					}
+					return inner++;
+				};
+				for(auto next=numLeaves;next<numNodes;++next){
+					const auto a = smallest(next);
+					const auto b = smallest(next);
+					weight[next] = weight[a] + weight[b];
+					parent[a] = next;
+					parent[b] = next;
+				}
+				std::vector<int> depth(numNodes, 0);
+				std::array<int, 2 * numLitLen> count{};
+				for(auto i=numNodes - 2;i>=0;--i){
+					depth[i] = depth[parent[i]] + 1;
+					if(i < numLeaves){
+						++count[depth[i]];
+					}
+				}
+				// moves the codes longer than limit up and fixes the kraft sum
+				for(auto i=limit + 1;i<static_cast<int>(count.size());++i){
+					count[limit] += count[i];
+					count[i] = 0;
+				}
+				std::uint32_t total = 0;
+				for(auto i=limit;i>0;--i){
+					total += static_cast<std::uint32_t>(count[i]) << (limit - i);
+				}
+				while(total != (1u << limit)){
+					--count[limit];
+					for(auto i=limit - 1;i>0;--i){
+						if(count[i] > 0){
+							--count[i];
+							count[i + 1] += 2;
+							break;
+						}
+					}
+					--total;
+				}
+				// the least frequent get the longest codes
+				auto next = 0;
+				for(auto len=limit;len>0;--len){
+					for(auto i=0;i<count[len];++i){
+						lengths[leaves[next++]] = static_cast<std::uint8_t>(len);
+					}
+				}
+			}
+			/**
+			 *  @brief canonical codes, bit reversed as deflate writes them from the most significant bit.
+			 */
+			void buildCodes(const std::uint8_t* lengths, int numSymbols, std::uint16_t* codes) noexcept{
+				std::array<std::uint16_t, maxBits + 2> count{};
+				for(auto i=0;i<numSymbols;++i){
+					++count[lengths[i]];
+				}
+				count[0] = 0;
+				std::array<std::uint16_t, maxBits + 2> next{};
+				std::uint16_t code = 0;
+				for(auto len=1;len<=maxBits;++len){
+					code = static_cast<std::uint16_t>((code + count[len - 1]) << 1);
+					next[len] = code;
+				}
+				for(auto i=0;i<numSymbols;++i){
+					const auto len = lengths[i];
+					if(len == 0){
+						codes[i] = 0;
+						continue;
+					}
+					auto c = next[len]++;
+					std::uint16_t reversed = 0;
+					for(auto b=0;b<len;++b){
+						reversed = static_cast<std::uint16_t>((reversed << 1) | (c & 1));
+						c >>= 1;
+					}
+					codes[i] = reversed;
+				}
+			}
+			std::size_t matchLength(const std::uint8_t* a, const std::uint8_t* b, std::size_t limit) noexcept{
+				std::size_t n = 0;
+				while(n + 8 <= limit){
+					std::uint64_t x, y;
+					std::memcpy(&x, a + n, sizeof(x));
+					std::memcpy(&y, b + n, sizeof(y));
+					if(x != y){
+						return n + (__builtin_ctzll(x ^ y) >> 3);
+					}
+					n += 8;
+				}
+				while(n < limit && a[n] == b[n]){
+					++n;
+				}
+				return n;
+			}
+			/**
+			 *  @brief LZ77 matcher and block writer, it is reused by the calls of the thread.
+			 */
+			class Compressor final{
+				public:
+					Compressor() noexcept
+					: m_head(hashSize)
+					, m_prev(windowSize)
+					, m_tokens(){
+						m_tokens.reserve(maxTokens);
+					}
+					void compress(const std::uint8_t* data, std::size_t size, const Level& level, BitWriter& writer) noexcept{
+						m_data = data;
+						m_size = size;
+						m_writer = &writer;
+						m_blockStart = 0;
+						m_emitted = 0;
+						resetBlock();
+						std::fill(std::begin(m_head), std::end(m_head), 0);
+						if(level.lazy){
+							lazy(level);
+						}else{
+							greedy(level);
+						}
+						writeBlock(true);
+					}
+				private:
+					struct Match final{
+						std::size_t length;
+						std::uint32_t dist;
+					};
+					std::uint32_t hash(std::size_t pos) const noexcept{
+						const auto* p = m_data + pos;
+						const auto v = static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) | (static_cast<std::uint32_t>(p[2]) << 16);
+						return (v * 0x9E3779B1u) >> (32 - hashBits);
+					}
+					void insert(std::size_t pos) noexcept{
+						if(pos + minMatch <= m_size){
+							const auto h = hash(pos);
+							m_prev[pos & (windowSize - 1)] = m_head[h];
+							m_head[h] = static_cast<std::uint32_t>(pos + 1);
+						}
+					}
+					/**
+					 *  @brief longest match at pos longer than minLength.
+					 */
+					Match longestMatch(std::size_t pos, std::size_t minLength, const Level& level) const noexcept{
+						const auto limit = std::min<std::size_t>(maxMatch, m_size - pos);
+						if(limit < minMatch || minLength >= limit){
+							return {0, 0};
+						}
+						const auto* cur = m_data + pos;
+						auto best = std::max<std::size_t>(minLength, minMatch - 1);
+						std::uint32_t bestDist = 0;
+						auto candidate = m_head[hash(pos)];
+						auto chain = minLength >= static_cast<std::size_t>(level.good) ? level.chain >> 2:level.chain;
+						for(;candidate != 0 && chain > 0;--chain){
+							const auto c = static_cast<std::size_t>(candidate - 1);
+							if(pos - c > windowSize){
+								break;
+							}
+							const auto* m = m_data + c;
+							// the last two bytes of a longer match first, they reject most candidates
+							if(m[best] == cur[best] && m[best - 1] == cur[best - 1] && m[0] == cur[0] && m[1] == cur[1]){
+								const auto length = matchLength(m, cur, limit);
+								if(length > best){
+									best = length;
+									bestDist = static_cast<std::uint32_t>(pos - c);
+									if(length >= static_cast<std::size_t>(level.nice) || length >= limit){
+										break;
+									}
+								}
+							}
+							const auto next = m_prev[c & (windowSize - 1)];
+							if(next >= candidate){
+								break;
+							}
+							candidate = next;
+						}
+						// a 3 bytes match that far costs more bits than the literals (like zlib's TOO_FAR)
+						if(bestDist == 0 || (best == minMatch && bestDist > 4096)){
+							return {0, 0};
+						}
+						return {best, bestDist};
+					}
+					void greedy(const Level& level) noexcept{
+						std::size_t pos = 0;
+						while(pos < m_size){
+							const auto match = longestMatch(pos, 0, level);
+							insert(pos);
+							if(match.length >= minMatch){
+								emitMatch(match);
+								if(match.length <= static_cast<std::size_t>(level.maxLazy)){
+									for(auto p=pos + 1;p<pos + match.length;++p){
+										insert(p);
+									}
+								}
+								pos += match.length;
+							}else{
+								emitLiteral(m_data[pos]);
+								++pos;
+							}
+						}
+					}
+					/**
+					 *  @brief a match is only taken if the one at the next position isn't longer.
+					 */
+					void lazy(const Level& level) noexcept{
+						std::size_t pos = 0;
+						Match previous{0, 0};
+						bool hasPrevious = false;
+						while(pos < m_size){
+							Match match{0, 0};
+							if(!hasPrevious || previous.length < static_cast<std::size_t>(level.maxLazy)){
+								match = longestMatch(pos, hasPrevious ? previous.length:0, level);
+							}
+							insert(pos);
+							if(hasPrevious && previous.length >= minMatch && match.length <= previous.length){
+								emitMatch(previous);
+								const auto end = pos - 1 + previous.length;
+								for(auto p=pos + 1;p<end;++p){
+									insert(p);
+								}
+								pos = end;
+								hasPrevious = false;
+								continue;
+							}
+							if(hasPrevious){
+								emitLiteral(m_data[pos - 1]);
+							}
+							previous = match;
+							hasPrevious = true;
+							++pos;
+						}
+						if(hasPrevious){
+							emitLiteral(m_data[pos - 1]);
+						}
+					}
+					void emitLiteral(std::uint8_t literal) noexcept{
+						m_tokens.emplace_back(literal);
+						++m_litLenFreq[literal];
+						++m_emitted;
+						flushIfFull();
+					}
+					void emitMatch(const Match& match) noexcept{
+						const auto& t = tables();
+						m_tokens.emplace_back((match.dist << 9) | static_cast<std::uint32_t>(match.length));
+						++m_litLenFreq[257 + t.lengthCode[match.length]];
+						++m_distFreq[t.getDistCode(match.dist)];
+						m_emitted += match.length;
+						flushIfFull();
+					}
+					void flushIfFull() noexcept{
+						if(m_tokens.size() >= maxTokens){
+							writeBlock(false);
+						}
+					}
+					void resetBlock() noexcept{
+						m_tokens.clear();
+						m_litLenFreq.fill(0);
+						m_distFreq.fill(0);
+					}
+					/**
+					 *  @brief bits of the tokens with the given code lengths.
+					 */
+					std::size_t dataBits(const std::uint8_t* litLenLengths, const std::uint8_t* distLengths) const noexcept{
+						std::size_t bits = litLenLengths[endOfBlock];
+						for(auto i=0;i<endOfBlock;++i){
+							bits += static_cast<std::size_t>(m_litLenFreq[i]) * litLenLengths[i];
+						}
+						for(auto i=0u;i<lengthBase.size();++i){
+							bits += static_cast<std::size_t>(m_litLenFreq[257 + i]) * (litLenLengths[257 + i] + lengthExtra[i]);
+						}
+						for(auto i=0;i<numDist;++i){
+							bits += static_cast<std::size_t>(m_distFreq[i]) * (distLengths[i] + distExtra[i]);
+						}
+						return bits;
+					}
+					void writeTokens(const std::uint8_t* litLenLengths, const std::uint16_t* litLenCodes,
+									 const std::uint8_t* distLengths, const std::uint16_t* distCodes) noexcept{
+						const auto& t = tables();
+						auto& w = *m_writer;
+						for(const auto token:m_tokens){
+							const auto dist = token >> 9;
+							const auto value = token & 0x1FF;
+							if(dist == 0){
+								w.put(litLenCodes[value], litLenLengths[value]);
+								continue;
+							}
+							const auto lc = t.lengthCode[value];
+							w.put(litLenCodes[257 + lc], litLenLengths[257 + lc]);
+							w.put(value - lengthBase[lc], lengthExtra[lc]);
+							const auto dc = t.getDistCode(dist);
+							w.put(distCodes[dc], distLengths[dc]);
+							w.put(dist - distBase[dc], distExtra[dc]);
+						}
+						w.put(litLenCodes[endOfBlock], litLenLengths[endOfBlock]);
+					}
+					/**
+					 *  @brief writes the tokens stored, with fixed or with dynamic codes, whatever is smaller.
+					 */
+					void writeBlock(bool final) noexcept{
+						const auto& t = tables();
+						auto& w = *m_writer;
+						++m_litLenFreq[endOfBlock];
+						std::array<std::uint8_t, numLitLen> litLenLengths{};
+						std::array<std::uint8_t, numDist> distLengths{};
+						buildLengths(m_litLenFreq.data(), numLitLen, maxBits, litLenLengths.data());
+						buildLengths(m_distFreq.data(), numDist, maxBits, distLengths.data());
+						auto numLit = numLitLen;
+						while(numLit > 257 && litLenLengths[numLit - 1] == 0){
+							--numLit;
+						}
+						auto numDistCodes = numDist;
+						while(numDistCodes > 1 && distLengths[numDistCodes - 1] == 0){
+							--numDistCodes;
+						}
+						// run length encoding of the code lengths, 16 repeats the previous, 17 and 18 repeat zeros
+						std::array<std::uint8_t, numLitLen + numDist> all{};
+						std::copy_n(std::begin(litLenLengths), numLit, std::begin(all));
+						std::copy_n(std::begin(distLengths), numDistCodes, std::begin(all) + numLit);
+						const auto numAll = numLit + numDistCodes;
+						std::array<std::uint16_t, numLitLen + numDist> runs{};
+						auto numRuns = 0;
+						std::array<std::uint32_t, numCodeLengths> clFreq{};
+						for(auto i=0;i<numAll;){
+							const auto len = all[i];
+							auto run = 1;
+							while(i + run < numAll && all[i + run] == len){
+								++run;
+							}
+							if(len == 0 && run >= 3){
+								run = std::min(run, 138);
+								const auto symbol = run <= 10 ? 17:18;
+								runs[numRuns++] = static_cast<std::uint16_t>(symbol | ((run - (symbol == 17 ? 3:11)) << 5));
+								++clFreq[symbol];
+							}else if(len != 0 && run >= 4){
+								run = std::min(run, 7);
+								runs[numRuns++] = len;
+								runs[numRuns++] = static_cast<std::uint16_t>(16 | ((run - 4) << 5));
+								++clFreq[len];
+								++clFreq[16];
+							}else{
+								run = 1;
+								runs[numRuns++] = len;
+								++clFreq[len];
+							}
+							i += run;
+						}
+						std::array<std::uint8_t, numCodeLengths> clLengths{};
+						buildLengths(clFreq.data(), numCodeLengths, maxCodeLengthBits, clLengths.data());
+						auto numCl = numCodeLengths;
+						while(numCl > 4 && clLengths[codeLengthOrder[numCl - 1]] == 0){
+							--numCl;
+						}
+						std::size_t dynamicBits = 3 + 5 + 5 + 4 + 3 * numCl + 2 * clFreq[16] + 3 * clFreq[17] + 7 * clFreq[18];
+						for(auto i=0;i<numCodeLengths;++i){
+							dynamicBits += static_cast<std::size_t>(clFreq[i]) * clLengths[i];
+						}
+						dynamicBits += dataBits(litLenLengths.data(), distLengths.data());
+						const auto fixedBits = 3 + dataBits(t.fixedLitLen.data(), t.fixedDist.data());
+						const auto blockBytes = m_emitted - m_blockStart;
+						const auto numStored = std::max<std::size_t>(1, (blockBytes + maxStored - 1) / maxStored);
+						const auto storedBits = (blockBytes + 5 * numStored) * 8 + 7;
+						if(storedBits <= fixedBits && storedBits <= dynamicBits){
+							for(auto i=0u;i<numStored;++i){
+								const auto start = m_blockStart + i * maxStored;
+								const auto length = std::min(maxStored, m_emitted - start);
+								w.put(final && i + 1 == numStored ? 1:0, 1);
+								w.put(0, 2);
+								w.align();
+								w.put(static_cast<std::uint32_t>(length), 16);
+								w.put(static_cast<std::uint32_t>(~length & 0xFFFF), 16);
+								w.bytes(m_data + start, length);
+							}
+						}else if(fixedBits <= dynamicBits){
+							std::array<std::uint16_t, 288> litLenCodes{};
+							std::array<std::uint16_t, 32> distCodes{};
+							buildCodes(t.fixedLitLen.data(), 288, litLenCodes.data());
+							buildCodes(t.fixedDist.data(), 32, distCodes.data());
+							w.put(final ? 1:0, 1);
+							w.put(1, 2);
+							writeTokens(t.fixedLitLen.data(), litLenCodes.data(), t.fixedDist.data(), distCodes.data());
+						}else{
+							std::array<std::uint16_t, numLitLen> litLenCodes{};
+							std::array<std::uint16_t, numDist> distCodes{};
+							std::array<std::uint16_t, numCodeLengths> clCodes{};
+							buildCodes(litLenLengths.data(), numLitLen, litLenCodes.data());
+							buildCodes(distLengths.data(), numDist, distCodes.data());
+							buildCodes(clLengths.data(), numCodeLengths, clCodes.data());
+							w.put(final ? 1:0, 1);
+							w.put(2, 2);
+							w.put(static_cast<std::uint32_t>(numLit - 257), 5);
+							w.put(static_cast<std::uint32_t>(numDistCodes - 1), 5);
+							w.put(static_cast<std::uint32_t>(numCl - 4), 4);
+							for(auto i=0;i<numCl;++i){
+								w.put(clLengths[codeLengthOrder[i]], 3);
+							}
+							for(auto i=0;i<numRuns;++i){
+								const auto symbol = runs[i] & 0x1F;
+								const auto repeat = static_cast<std::uint32_t>(runs[i] >> 5);
+								w.put(clCodes[symbol], clLengths[symbol]);
+								if(symbol == 16){
+									w.put(repeat, 2);
+								}else if(symbol == 17){
+									w.put(repeat, 3);
+								}else if(symbol == 18){
+									w.put(repeat, 7);
+								}
+							}
+							writeTokens(litLenLengths.data(), litLenCodes.data(), distLengths.data(), distCodes.data());
+						}
+						m_blockStart = m_emitted;
+						resetBlock();
+					}
+				private:
+					std::vector<std::uint32_t> m_head;
+					std::vector<std::uint32_t> m_prev;
+					/// literal or (dist << 9 | length)
+					std::vector<std::uint32_t> m_tokens;
+					std::array<std::uint32_t, numLitLen> m_litLenFreq{};
+					std::array<std::uint32_t, numDist> m_distFreq{};
+					const std::uint8_t* m_data{nullptr};
+					std::size_t m_size{0};
+					BitWriter* m_writer{nullptr};
+					std::size_t m_blockStart{0};
+					std::size_t m_emitted{0};
+			};
+		} // namespace
+		std::size_t zlibBound(std::size_t size) noexcept{
+			// header, adler32 and up to 6 bytes for each stored block (blocks also end every maxTokens tokens,
+			// so every >= maxTokens bytes) plus the padding of the blocks
+			return 2 + 4 + size + 8 * (size / maxStored + size / maxTokens + 2);
+		}
+		std::size_t zlib(const std::uint8_t* data, std::size_t size, int level, std::uint8_t* out) noexcept{
+			level = std::clamp(level, 0, 9);
+			// 32K window deflate, FLEVEL from the level and FCHECK to make the header a multiple of 31
+			const std::uint32_t cmf = 0x78;
+			const std::uint32_t flevel = level < 2 ? 0:level < 6 ? 1:level == 6 ? 2:3;
+			auto flg = flevel << 6;
+			flg += 31 - (cmf * 256 + flg) % 31;
+			out[0] = static_cast<std::uint8_t>(cmf);
+			out[1] = static_cast<std::uint8_t>(flg);
+			BitWriter writer(out + 2);
+			if(level == 0){
+				std::size_t pos = 0;
+				do{
+					const auto length = std::min(maxStored, size - pos);
+					writer.put(pos + length == size ? 1:0, 1);
+					writer.put(0, 2);
+					writer.align();
+					writer.put(static_cast<std::uint32_t>(length), 16);
+					writer.put(static_cast<std::uint32_t>(~length & 0xFFFF), 16);
+					writer.bytes(data + pos, length);
+					pos += length;
+				}while(pos < size);
+			}else{
+				thread_local Compressor compressor;
+				compressor.compress(data, size, levels[level], writer);
+				writer.align();
+			}
+			auto end = 2 + writer.size();
+			const auto adler = adler32(data, size);
+			for(auto shift=24;shift>=0;shift-=8){
+				out[end++] = static_cast<std::uint8_t>(adler >> shift);
+			}
+			return end;
+		}
+		std::uint32_t crc32(const std::uint8_t* data, std::size_t size, std::uint32_t crc) noexcept{
+			const auto& table = tables().crc;
+			crc = ~crc;
+			for(auto i=0u;i<size;++i){
+				crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+			}
+			return ~crc;
+		}
+		std::uint32_t adler32(const std::uint8_t* data, std::size_t size, std::uint32_t adler) noexcept{
+			// largest n such that 255n(n+1)/2 + (n+1)(65520) fits in 32 bits
+			constexpr std::size_t nmax = 5552;
+			std::uint32_t a = adler & 0xFFFF;
+			std::uint32_t b = adler >> 16;
+			while(size > 0){
+				const auto n = std::min(size, nmax);
+				for(auto i=0u;i<n;++i){
+					a += data[i];
+					b += a;
+				}
+				a %= 65521;
+				b %= 65521;
+				data += n;
+				size -= n;
+			}
+			return (b << 16) | a;
+		}
+	} // namespace deflate
+} // namespace fe
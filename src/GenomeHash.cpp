@@ -0,0 +1,117 @@
+#include <GenomeHash.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <tuple>
+#include <vector>
+
+namespace fe{
+	namespace{
+		/**
+		 *  @brief mixes value into the hash (splitmix64 finalizer).
+		 */
+		std::uint64_t combine(std::uint64_t hash, std::uint64_t value) noexcept{
+			hash ^= value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+			hash ^= hash >> 30;
+			hash *= 0xBF58476D1CE4E5B9ull;
+			hash ^= hash >> 27;
+			hash *= 0x94D049BB133111EBull;
+			hash ^= hash >> 31;
+			return hash;
+		}
+		/**
+		 *  @brief two independent 64 bits lanes.
+		 */
+		struct Hasher final{
+			std::uint64_t high{0x6A09E667F3BCC908ull};
+			std::uint64_t low{0xBB67AE8584CAA73Bull};
+			void add(std::uint64_t value) noexcept{
+				high = combine(high, value);
+				low = combine(low, value ^ 0xA54FF53A5F1D36F1ull);
+			}
+		};
+		/**
+		 *  @brief value rounded to a multiple of precision (or its bits if precision is 0).
+		 */
+		std::uint64_t quantize(double value, double precision) noexcept{
+			if(value == 0.0){
+				// -0.0 and 0.0
+				return 0;
+			}
+			if(precision > 0.0 && std::isfinite(value)){
+				const auto steps = std::round(value / precision);
+				if(std::abs(steps) < 9.0e18){
+					return static_cast<std::uint64_t>(static_cast<std::int64_t>(steps));
+				}
+			}
+			std::uint64_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			return bits;
+		}
+		void hashInto(Hasher& h, const EvoAI::Genome& g, double precision) noexcept{
+			using NodeKey = std::tuple<std::size_t, std::size_t, std::uint64_t, std::uint64_t, std::uint64_t>;
+			using ConnectionKey = std::tuple<std::size_t, std::size_t, std::size_t, std::size_t, std::uint64_t>;
+			std::vector<NodeKey> nodes;
+			nodes.reserve(g.getNodeChromosomes().size());
+			for(const auto& n:g.getNodeChromosomes()){
+				nodes.emplace_back(n.getLayerID(), n.getNeuronID(), static_cast<std::uint64_t>(n.getNeuronType()),
+									static_cast<std::uint64_t>(n.getActType()), quantize(n.getBias(), precision));
+			}
+			std::vector<ConnectionKey> connections;
+			connections.reserve(g.getConnectionChromosomes().size());
+			for(const auto& c:g.getConnectionChromosomes()){
+				if(c.isEnabled()){
+					connections.emplace_back(c.getSrc().layer, c.getSrc().neuron, c.getDest().layer, c.getDest().neuron,
+											quantize(c.getWeight(), precision));
+				}
+			}
+			std::sort(std::begin(nodes), std::end(nodes));
+			std::sort(std::begin(connections), std::end(connections));
+			h.add(nodes.size());
+			for(const auto& [layer, id, type, act, bias]:nodes){
+				h.add(layer);
+				h.add(id);
+				h.add(type);
+				h.add(act);
+				h.add(bias);
+			}
+			h.add(connections.size());
+			for(const auto& [srcLayer, srcNeuron, destLayer, destNeuron, weight]:connections){
+				h.add(srcLayer);
+				h.add(srcNeuron);
+				h.add(destLayer);
+				h.add(destNeuron);
+				h.add(weight);
+			}
+		}
+	} // namespace
+	std::string GenomeHash::toString() const noexcept{
+		constexpr char digits[] = "0123456789abcdef";
+		std::string str(32, '0');
+		for(auto i=0u;i<16u;++i){
+			str[15 - i] = digits[(high >> (i * 4)) & 0xF];
+			str[31 - i] = digits[(low >> (i * 4)) & 0xF];
+		}
+		return str;
+	}
+	bool GenomeHash::operator==(const GenomeHash& rhs) const noexcept{
+		return high == rhs.high && low == rhs.low;
+	}
+	bool GenomeHash::operator!=(const GenomeHash& rhs) const noexcept{
+		return !(*this == rhs);
+	}
+	GenomeHash hashGenome(const EvoAI::Genome& g, double precision) noexcept{
+		Hasher h;
+		hashInto(h, g, precision);
+		return {h.high, h.low};
+	}
+	GenomeHash hashDNA(const DNA& dna, double precision) noexcept{
+		Hasher h;
+		h.add(dna.size());
+		for(auto i=0u;i<dna.size();++i){
+			hashInto(h, dna[i], precision);
+		}
+		return {h.high, h.low};
+	}
+} // namespace fe
@@ -0,0 +1,98 @@
+#include <GenomeRegistry.hpp>
+#include <JsonReader.hpp>
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace fe{
+	namespace{
+		/**
+		 *  @brief least recently used cache of loaded genomes limited by count.
+		 */
+		struct GenomeRegistry final{
+			struct Entry{
+				int handle;
+				std::shared_ptr<const LoadedGenome> genome;
+				std::uint64_t lastUse;
+			};
+			std::mutex mutex;
+			std::vector<Entry> entries;
+			std::size_t limit{256};
+			std::uint64_t clock{0};
+			int nextHandle{1};
+			/**
+			 *  @brief evicts least recently used genomes until extra genomes fit in the limit.
+			 */
+			void evict(std::size_t extra) noexcept{
+				while(!entries.empty() && entries.size() + extra > limit){
+					auto lru = std::min_element(std::begin(entries), std::end(entries), [](const Entry& a, const Entry& b){
+						return a.lastUse < b.lastUse;
+					});
+					entries.erase(lru);
+				}
+			}
+			std::vector<Entry>::iterator find(int handle) noexcept{
+				return std::find_if(std::begin(entries), std::end(entries), [handle](const Entry& e){
+					return e.handle == handle;
+				});
+			}
+		};
+		GenomeRegistry& genomeRegistry() noexcept{
+			static GenomeRegistry registry;
+			return registry;
+		}
+	} // namespace
+	int loadGenome(const std::string& flower){
+		return loadGenome(readFlowerDNA(flower));
+	}
+	int loadGenome(DNA&& dna){
+		if(dna.size() < 2){
+			throw std::invalid_argument("invalid DNA, it should have 2 genomes");
+		}
+		auto genome = std::make_shared<LoadedGenome>();
+		genome->dna = std::move(dna);
+		genome->petals = getCPPN(genome->dna[1]);
+		auto& registry = genomeRegistry();
+		std::lock_guard lock(registry.mutex);
+		if(registry.limit == 0){
+			throw std::invalid_argument("error, the genome limit is 0, genomes can't be loaded.");
+		}
+		const auto handle = registry.nextHandle++;
+		registry.evict(1);
+		registry.entries.push_back({handle, std::move(genome), ++registry.clock});
+		return handle;
+	}
+	bool releaseGenome(int handle) noexcept{
+		auto& registry = genomeRegistry();
+		std::lock_guard lock(registry.mutex);
+		auto it = registry.find(handle);
+		if(it == std::end(registry.entries)){
+			return false;
+		}
+		registry.entries.erase(it);
+		return true;
+	}
+	std::shared_ptr<const LoadedGenome> getGenome(int handle){
+		auto& registry = genomeRegistry();
+		std::lock_guard lock(registry.mutex);
+		auto it = registry.find(handle);
+		if(it == std::end(registry.entries)){
+			throw std::invalid_argument("error, unknown genome handle " + std::to_string(handle) + ", it was released or evicted.");
+		}
+		it->lastUse = ++registry.clock;
+		return it->genome;
+	}
+	void setGenomeLimit(std::size_t maxGenomes) noexcept{
+		auto& registry = genomeRegistry();
+		std::lock_guard lock(registry.mutex);
+		registry.limit = maxGenomes;
+		registry.evict(0);
+	}
+	void clearGenomes() noexcept{
+		auto& registry = genomeRegistry();
+		std::lock_guard lock(registry.mutex);
+		registry.entries.clear();
+	}
+} // namespace fe
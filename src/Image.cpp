@@ -1,11 +1,17 @@
 #include <Image.hpp>
+#include <Deflate.hpp>
+#include <Profile.hpp>
 
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include <stb_image_write.h>
-
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
 #include <limits>
 #include <string>
-#include <sstream>
+
+#if defined(__wasm_simd128__)
+    #include <wasm_simd128.h>
+#endif
 
 namespace fe{
     Image::Image() noexcept
@@ -43,72 +49,348 @@ namespace fe{
     bool isBase64(unsigned char c){
         return (std::isalnum(c) || (c == '+') || (c == '/'));
     }
+    namespace{
+        constexpr char base64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                       "abcdefghijklmnopqrstuvwxyz"
+                                       "0123456789+/";
+        /**
+         * @brief the two chars of each 12 bits, 3 bytes are written with two lookups.
+         */
+        constexpr std::array<char, 8192> makeBase64Pairs() noexcept{
+            std::array<char, 8192> pairs{};
+            for(auto i=0u;i<4096u;++i){
+                pairs[2 * i] = base64Chars[i >> 6];
+                pairs[2 * i + 1] = base64Chars[i & 0x3F];
+            }
+            return pairs;
+        }
+        constexpr auto base64Pairs = makeBase64Pairs();
+        /**
+         * @brief encodes 3 * n bytes without padding.
+         */
+        char* encodeBase64Triples(const std::uint8_t* data, std::size_t n, char* out) noexcept{
+            for(auto i=0u;i<n;++i, data += 3, out += 4){
+                const auto v = (std::uint32_t{data[0]} << 16) | (std::uint32_t{data[1]} << 8) | data[2];
+                std::memcpy(out, &base64Pairs[2 * (v >> 12)], 2);
+                std::memcpy(out + 2, &base64Pairs[2 * (v & 0xFFF)], 2);
+            }
+            return out;
+        }
+#if defined(__wasm_simd128__)
+        /**
+         * @brief encodes 12 bytes to 16 chars per iteration while 16 bytes can be loaded.
+         * @return std::size_t bytes encoded, a multiple of 12.
+         */
+        std::size_t encodeBase64Simd(const std::uint8_t* data, std::size_t size, char*& out) noexcept{
+            // each lane gets the bytes b1 b0 b2 b1 of a triple so the four 6 bit indices are in reach of a shift
+            const auto shuffle = wasm_i8x16_make(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+            // ascii offset of each range of indices: [0, 25] 'A', [26, 51] 'a', [52, 61] '0', 62 '+' and 63 '/'
+            const auto offsets = wasm_i8x16_make(71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 65, 0, 0);
+            std::size_t i = 0;
+            for(;i + 16 <= size;i += 12, out += 16){
+                const auto in = wasm_i8x16_swizzle(wasm_v128_load(data + i), shuffle);
+                const auto indices = wasm_v128_or(
+                    wasm_v128_or(wasm_v128_and(wasm_u32x4_shr(in, 10), wasm_i32x4_splat(0x0000003F)),
+                                 wasm_v128_and(wasm_i32x4_shl(in, 4), wasm_i32x4_splat(0x00003F00))),
+                    wasm_v128_or(wasm_v128_and(wasm_u32x4_shr(in, 6), wasm_i32x4_splat(0x003F0000)),
+                                 wasm_v128_and(wasm_i32x4_shl(in, 8), wasm_i32x4_splat(0x3F000000))));
+                // 0 for [0, 51], 1..12 for 52..63 and 13 for the uppercase letters
+                auto range = wasm_u8x16_sub_sat(indices, wasm_u8x16_splat(51));
+                range = wasm_v128_bitselect(wasm_u8x16_splat(13), range, wasm_u8x16_lt(indices, wasm_u8x16_splat(26)));
+                wasm_v128_store(out, wasm_i8x16_add(indices, wasm_i8x16_swizzle(offsets, range)));
+            }
+            return i;
+        }
+#endif
+    } // namespace
+    std::size_t base64Size(std::size_t size) noexcept{
+        return (size + 2) / 3 * 4;
+    }
+    char* encodeToBase64(const std::uint8_t* data, std::size_t size, char* out) noexcept{
+        FE_PROFILE_SCOPE(Base64);
+        FE_PROFILE_COUNT(Base64Bytes, base64Size(size));
+        std::size_t i = 0;
+#if defined(__wasm_simd128__)
+        i = encodeBase64Simd(data, size, out);
+#endif
+        const auto triples = (size - i) / 3;
+        out = encodeBase64Triples(data + i, triples, out);
+        i += triples * 3;
+        if(i < size){
+            const auto v = (std::uint32_t{data[i]} << 16) | (i + 1 < size ? std::uint32_t{data[i + 1]} << 8:0u);
+            out[0] = base64Chars[v >> 18];
+            out[1] = base64Chars[(v >> 12) & 0x3F];
+            out[2] = i + 1 < size ? base64Chars[(v >> 6) & 0x3F]:'=';
+            out[3] = '=';
+            out += 4;
+        }
+        return out;
+    }
+    void appendBase64(std::string& out, const std::uint8_t* data, std::size_t size){
+        const auto offset = out.size();
+        out.resize(offset + base64Size(size));
+        encodeToBase64(data, size, &out[offset]);
+    }
     std::string encodeToBase64(const std::vector<std::uint8_t>& data){
-        if(data.empty()){
-            return "";
-        }
-        static const std::string base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-                                                "abcdefghijklmnopqrstuvwxyz"
-                                                "0123456789+/";
-        std::stringstream ss;
-        int i = 0;
-        int j = 0;
-        unsigned char char_array_3[3];
-        unsigned char char_array_4[4];
-        auto in_len = data.size();
-        auto bytes_to_encode = data.data();
-        while(in_len--){
-            char_array_3[i++] = *(bytes_to_encode++);
-            if(i == 3){
-                char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-                char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-                char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-                char_array_4[3] = char_array_3[2] & 0x3f;
-    
-                for(i = 0; i < 4; i++){
-                    ss << base64_chars[char_array_4[i]];
-                }
-                i = 0;
+        std::string base64;
+        appendBase64(base64, data.data(), data.size());
+        return base64;
+    }
+    namespace{
+        constexpr std::uint8_t pngSignature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        std::uint8_t* writeBigEndian(std::uint8_t* out, std::uint32_t v) noexcept{
+            out[0] = static_cast<std::uint8_t>(v >> 24);
+            out[1] = static_cast<std::uint8_t>(v >> 16);
+            out[2] = static_cast<std::uint8_t>(v >> 8);
+            out[3] = static_cast<std::uint8_t>(v);
+            return out + 4;
+        }
+        /**
+         * @brief writes the crc of the chunk that starts at chunk (length, type and data).
+         */
+        std::uint8_t* endChunk(std::uint8_t* chunk, std::size_t dataSize) noexcept{
+            return writeBigEndian(chunk + 8 + dataSize, fe::deflate::crc32(chunk + 4, 4 + dataSize));
+        }
+        std::uint8_t paeth(int a, int b, int c) noexcept{
+            const auto p = a + b - c;
+            const auto pa = std::abs(p - a);
+            const auto pb = std::abs(p - b);
+            const auto pc = std::abs(p - c);
+            if(pa <= pb && pa <= pc){
+                return static_cast<std::uint8_t>(a);
+            }
+            return static_cast<std::uint8_t>(pb <= pc ? b:c);
+        }
+        /**
+         * @brief filters a row of rgba pixels, prev is the unfiltered previous row (zeros for the first).
+         */
+        void filterRow(int filter, const std::uint8_t* row, const std::uint8_t* prev, std::size_t stride, std::uint8_t* out) noexcept{
+            constexpr std::size_t bpp = 4;
+            switch(filter){
+                case 1:
+                    std::copy_n(row, bpp, out);
+                    for(auto i=bpp;i<stride;++i){
+                        out[i] = static_cast<std::uint8_t>(row[i] - row[i - bpp]);
+                    }
+                    break;
+                case 2:
+                    for(auto i=0u;i<stride;++i){
+                        out[i] = static_cast<std::uint8_t>(row[i] - prev[i]);
+                    }
+                    break;
+                case 3:
+                    for(auto i=0u;i<bpp;++i){
+                        out[i] = static_cast<std::uint8_t>(row[i] - (prev[i] >> 1));
+                    }
+                    for(auto i=bpp;i<stride;++i){
+                        out[i] = static_cast<std::uint8_t>(row[i] - ((row[i - bpp] + prev[i]) >> 1));
+                    }
+                    break;
+                case 4:
+                    for(auto i=0u;i<bpp;++i){
+                        out[i] = static_cast<std::uint8_t>(row[i] - prev[i]);
+                    }
+                    for(auto i=bpp;i<stride;++i){
+                        out[i] = static_cast<std::uint8_t>(row[i] - paeth(row[i - bpp], prev[i], prev[i - bpp]));
+                    }
+                    break;
+                default:
+                    std::copy_n(row, stride, out);
+                    break;
             }
         }
-        if(i > 0){
-            for(j = i; j < 3; j++){
-                char_array_3[j] = '\0';
+        /**
+         * @brief sum of the filtered bytes as signed, smaller usually compresses better.
+         */
+        std::uint32_t filterCost(const std::uint8_t* filtered, std::size_t stride) noexcept{
+            std::uint32_t cost = 0;
+            for(auto i=0u;i<stride;++i){
+                cost += filtered[i] < 128 ? filtered[i]:256 - filtered[i];
             }
-            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-            char_array_4[3] = char_array_3[2] & 0x3f;
-            for(j = 0; j < i + 1; j++){
-                ss << base64_chars[char_array_4[j]];
+            return cost;
+        }
+        /**
+         * @brief filters the rows [first, last) into out (filter byte + row), -1 picks the filter of each row with filterCost.
+         */
+        void filterRows(int filter, const std::uint8_t* pixels, std::size_t stride, std::size_t first, std::size_t last, std::uint8_t* out) noexcept{
+            // zeros is the row above the first one, candidates keeps the best row and tries the next
+            thread_local std::vector<std::uint8_t> zeros;
+            thread_local std::vector<std::uint8_t> candidates;
+            zeros.assign(stride, 0);
+            if(filter < 0){
+                candidates.resize(stride * 2);
             }
-            while((i++ < 3)){
-                ss << '=';
+            for(auto y=first;y<last;++y, out+=stride + 1){
+                const auto* row = pixels + y * stride;
+                const auto* prev = y > 0 ? row - stride:zeros.data();
+                if(filter >= 0){
+                    out[0] = static_cast<std::uint8_t>(filter);
+                    filterRow(filter, row, prev, stride, out + 1);
+                    continue;
+                }
+                auto best = 0;
+                auto bestCost = filterCost(row, stride);
+                std::copy_n(row, stride, candidates.data());
+                for(auto f=1;f<=4;++f){
+                    filterRow(f, row, prev, stride, candidates.data() + stride);
+                    const auto cost = filterCost(candidates.data() + stride, stride);
+                    if(cost < bestCost){
+                        best = f;
+                        bestCost = cost;
+                        std::copy_n(candidates.data() + stride, stride, candidates.data());
+                    }
+                }
+                out[0] = static_cast<std::uint8_t>(best);
+                std::copy_n(candidates.data(), stride, out + 1);
             }
         }
-        return ss.str();
-    }    
-    std::vector<std::uint8_t> encodeImageToPngInMemory(const Image& image){
-        int pngDataLength = 0;
-        int width = image.getSize().x;
-        int height = image.getSize().y;
-        int stride_in_bytes = width * 4;
-        unsigned char *pngDataPtr = stbi_write_png_to_mem(
-            image.imageData.data(),
-            stride_in_bytes,
-            width,
-            height,
-            4,
-            &pngDataLength
-        );
-        if(!pngDataPtr || pngDataLength == 0){
-            if(pngDataPtr){
-                STBIW_FREE(pngDataPtr);
+        /**
+         * @brief compresses a few bands of rows with each filter (and the per row one) at level 1 and returns
+         *        the smallest, the flowers have few colors that repeat exactly so none tends to win.
+         */
+        int chooseFilter(const std::uint8_t* pixels, std::size_t stride, std::size_t height) noexcept{
+            constexpr std::size_t numBands = 4;
+            constexpr std::size_t bandRows = 8;
+            const auto rows = std::min(height / numBands, bandRows);
+            thread_local std::vector<std::uint8_t> bands;
+            thread_local std::vector<std::uint8_t> compressed;
+            bands.resize(numBands * rows * (stride + 1));
+            compressed.resize(fe::deflate::zlibBound(bands.size()));
+            auto best = 0;
+            auto bestSize = std::numeric_limits<std::size_t>::max();
+            for(const auto filter:{0, 1, 2, 4, -1}){
+                for(auto band=0u;band<numBands;++band){
+                    // centered in each quarter of the image
+                    const auto first = std::min(height * (2 * band + 1) / (2 * numBands), height - rows);
+                    filterRows(filter, pixels, stride, first, first + rows, bands.data() + band * rows * (stride + 1));
+                }
+                const auto size = fe::deflate::zlib(bands.data(), bands.size(), 1, compressed.data());
+                if(size < bestSize){
+                    best = filter;
+                    bestSize = size;
+                }
             }
+            return best;
+        }
+    } // namespace
+    void encodeImageToPng(const Image& image, std::vector<std::uint8_t>& png, const PngOptions& options){
+        FE_PROFILE_SCOPE(EncodePng);
+        png.clear();
+        const auto width = image.mWidth;
+        const auto height = image.mHeight;
+        if(width == 0 || height == 0 || image.imageData.size() < width * height * 4){
+            return;
+        }
+        const auto level = std::clamp(options.level, 0, 9);
+        const auto stride = width * 4;
+        const auto* pixels = image.imageData.data();
+        auto filter = std::clamp(options.filter, -1, 4);
+        if(filter < 0){
+            // stored rows don't get smaller with a filter
+            filter = level == 0 ? 0:chooseFilter(pixels, stride, height);
+        }
+        // reused by the encodes of the thread
+        thread_local std::vector<std::uint8_t> filtered;
+        filtered.resize(height * (stride + 1));
+        filterRows(filter, pixels, stride, 0, height, filtered.data());
+        // signature, IHDR, IDAT with the zlib stream written in place, IEND
+        png.resize(sizeof(pngSignature) + 25 + 12 + fe::deflate::zlibBound(filtered.size()) + 12);
+        auto* out = std::copy(std::begin(pngSignature), std::end(pngSignature), png.data());
+        auto* chunk = out;
+        out = writeBigEndian(out, 13);
+        out = std::copy_n("IHDR", 4, out);
+        out = writeBigEndian(out, static_cast<std::uint32_t>(width));
+        out = writeBigEndian(out, static_cast<std::uint32_t>(height));
+        // 8 bits rgba, deflate, adaptive filters, not interlaced
+        const std::uint8_t header[] = {8, 6, 0, 0, 0};
+        out = std::copy(std::begin(header), std::end(header), out);
+        out = endChunk(chunk, 13);
+        chunk = out;
+        const auto idatSize = fe::deflate::zlib(filtered.data(), filtered.size(), level, chunk + 8);
+        writeBigEndian(chunk, static_cast<std::uint32_t>(idatSize));
+        std::copy_n("IDAT", 4, chunk + 4);
+        out = endChunk(chunk, idatSize);
+        chunk = out;
+        out = writeBigEndian(out, 0);
+        out = std::copy_n("IEND", 4, out);
+        out = endChunk(chunk, 0);
+        png.resize(static_cast<std::size_t>(out - png.data()));
+        FE_PROFILE_COUNT(PngBytes, png.size());
+    }
+    std::vector<std::uint8_t> encodeImageToPngInMemory(const Image& image, const PngOptions& options){
+        std::vector<std::uint8_t> png;
+        encodeImageToPng(image, png, options);
+        return png;
+    }
+    std::vector<std::uint8_t> encodeImageToQoiInMemory(const Image& image){
+        const auto width = image.mWidth;
+        const auto height = image.mHeight;
+        if(width == 0 || height == 0 || image.imageData.size() < width * height * 4){
             return {};
         }
-        std::vector<std::uint8_t> pngEncodedData(pngDataPtr, pngDataPtr + pngDataLength);
-        STBIW_FREE(pngDataPtr);    
-        return pngEncodedData;
+        constexpr std::uint8_t opIndex = 0x00;
+        constexpr std::uint8_t opDiff = 0x40;
+        constexpr std::uint8_t opLuma = 0x80;
+        constexpr std::uint8_t opRun = 0xc0;
+        constexpr std::uint8_t opRGB = 0xfe;
+        constexpr std::uint8_t opRGBA = 0xff;
+        const auto numPixels = width * height;
+        std::vector<std::uint8_t> qoi;
+        // header + worst case (opRGBA per pixel) + end marker
+        qoi.reserve(14 + numPixels * 5 + 8);
+        auto write32 = [&qoi](std::uint32_t v){
+            qoi.insert(std::end(qoi), {static_cast<std::uint8_t>(v >> 24), static_cast<std::uint8_t>(v >> 16),
+                                        static_cast<std::uint8_t>(v >> 8), static_cast<std::uint8_t>(v)});
+        };
+        qoi.insert(std::end(qoi), {'q', 'o', 'i', 'f'});
+        write32(static_cast<std::uint32_t>(width));
+        write32(static_cast<std::uint32_t>(height));
+        qoi.push_back(4); // channels
+        qoi.push_back(0); // sRGB with linear alpha
+        std::array<std::array<std::uint8_t, 4>, 64> seen{};
+        std::array<std::uint8_t, 4> prev{0, 0, 0, 255};
+        int run = 0;
+        const auto* px = image.imageData.data();
+        for(auto i=0u;i<numPixels;++i, px+=4){
+            const std::array<std::uint8_t, 4> cur{px[0], px[1], px[2], px[3]};
+            if(cur == prev){
+                ++run;
+                if(run == 62 || i + 1 == numPixels){
+                    qoi.push_back(opRun | static_cast<std::uint8_t>(run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+            if(run > 0){
+                qoi.push_back(opRun | static_cast<std::uint8_t>(run - 1));
+                run = 0;
+            }
+            const auto hash = (cur[0] * 3 + cur[1] * 5 + cur[2] * 7 + cur[3] * 11) % 64;
+            if(seen[hash] == cur){
+                qoi.push_back(opIndex | static_cast<std::uint8_t>(hash));
+            }else{
+                seen[hash] = cur;
+                if(cur[3] == prev[3]){
+                    const auto dr = static_cast<std::int8_t>(cur[0] - prev[0]);
+                    const auto dg = static_cast<std::int8_t>(cur[1] - prev[1]);
+                    const auto db = static_cast<std::int8_t>(cur[2] - prev[2]);
+                    const auto drdg = static_cast<std::int8_t>(dr - dg);
+                    const auto dbdg = static_cast<std::int8_t>(db - dg);
+                    if(dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1){
+                        qoi.push_back(opDiff | static_cast<std::uint8_t>((dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+                    }else if(dg >= -32 && dg <= 31 && drdg >= -8 && drdg <= 7 && dbdg >= -8 && dbdg <= 7){
+                        qoi.push_back(opLuma | static_cast<std::uint8_t>(dg + 32));
+                        qoi.push_back(static_cast<std::uint8_t>((drdg + 8) << 4 | (dbdg + 8)));
+                    }else{
+                        qoi.insert(std::end(qoi), {opRGB, cur[0], cur[1], cur[2]});
+                    }
+                }else{
+                    qoi.insert(std::end(qoi), {opRGBA, cur[0], cur[1], cur[2], cur[3]});
+                }
+            }
+            prev = cur;
+        }
+        qoi.insert(std::end(qoi), {0, 0, 0, 0, 0, 0, 0, 1});
+        return qoi;
     }
-}
\ No newline at end of file
+}
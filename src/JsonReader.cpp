@@ -0,0 +1,383 @@
+#include <JsonReader.hpp>
+#include <Profile.hpp>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <JsonBox.h>
+
+namespace fe{
+	namespace{
+		/// nested arrays and objects the reader accepts.
+		constexpr int maxDepth = 64;
+		/**
+		 *  @brief thrown when the document isn't one the reader understands, JsonBox reads it instead.
+		 */
+		struct Unreadable final{};
+		/**
+		 *  @brief recursive descent reader over the string, values are built in place.
+		 */
+		class Reader final{
+			public:
+				explicit Reader(const std::string& json) noexcept
+				: m_pos(json.c_str())
+				, m_end(json.c_str() + json.size()){}
+				/**
+				 *  @brief reads {"Flower": {"dna": {"genomes": [...]}}}, the rest is skipped.
+				 *  @return bool false if it has no dna.
+				 */
+				bool flower(std::vector<EvoAI::Genome>& genomes){
+					return flowerMember("dna", [&](){
+						return dna(genomes);
+					});
+				}
+				/**
+				 *  @brief reads {"Flower": {"petals": {...}}}, the rest is skipped.
+				 *  @return bool false if it has no petals object.
+				 */
+				bool petals(JsonBox::Value& petals){
+					return flowerMember("petals", [&](){
+						value(petals, 2);
+						return petals.isObject();
+					});
+				}
+			private:
+				/**
+				 *  @brief calls read() for the member name of Flower, the rest of the document is skipped.
+				 *  @return bool what the last read() returned, false if there is no such member.
+				 */
+				template<typename Fn>
+				bool flowerMember(const std::string& name, Fn&& read){
+					bool found = false;
+					members(0, [&](const std::string& key){
+						if(key != "Flower"){
+							skip(1);
+							return;
+						}
+						members(1, [&](const std::string& flowerKey){
+							if(flowerKey != name){
+								skip(2);
+								return;
+							}
+							found = read();
+						});
+					});
+					whitespace();
+					if(m_pos != m_end){
+						throw Unreadable{};
+					}
+					return found;
+				}
+				bool dna(std::vector<EvoAI::Genome>& genomes){
+					if(peek() != '{'){
+						throw Unreadable{};
+					}
+					genomes.clear();
+					members(2, [&](const std::string& key){
+						if(key != "genomes"){
+							skip(3);
+							return;
+						}
+						genomes.clear();
+						elements(3, [&](){
+							JsonBox::Value genome;
+							value(genome, 4);
+							if(!genome.isObject()){
+								throw Unreadable{};
+							}
+							genomes.emplace_back(std::move(genome.getObject()));
+						});
+					});
+					return true;
+				}
+				char peek() noexcept{
+					whitespace();
+					return m_pos < m_end ? *m_pos:'\0';
+				}
+				void whitespace() noexcept{
+					while(m_pos < m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t')){
+						++m_pos;
+					}
+				}
+				void expect(char c){
+					if(peek() != c){
+						throw Unreadable{};
+					}
+					++m_pos;
+				}
+				bool literal(const char* word) noexcept{
+					const auto length = std::strlen(word);
+					if(static_cast<std::size_t>(m_end - m_pos) < length || std::strncmp(m_pos, word, length) != 0){
+						return false;
+					}
+					m_pos += length;
+					return true;
+				}
+				/**
+				 *  @brief calls fn(key) for each member of an object, fn has to read the value.
+				 */
+				template<typename Fn>
+				void members(int depth, Fn&& fn){
+					if(depth > maxDepth){
+						throw Unreadable{};
+					}
+					expect('{');
+					if(peek() == '}'){
+						++m_pos;
+						return;
+					}
+					std::string key;
+					while(true){
+						expect('"');
+						string(key);
+						expect(':');
+						fn(key);
+						if(peek() == ','){
+							++m_pos;
+							continue;
+						}
+						expect('}');
+						return;
+					}
+				}
+				/**
+				 *  @brief calls fn() for each element of an array, fn has to read the element.
+				 */
+				template<typename Fn>
+				void elements(int depth, Fn&& fn){
+					if(depth > maxDepth){
+						throw Unreadable{};
+					}
+					expect('[');
+					if(peek() == ']'){
+						++m_pos;
+						return;
+					}
+					while(true){
+						fn();
+						if(peek() == ','){
+							++m_pos;
+							continue;
+						}
+						expect(']');
+						return;
+					}
+				}
+				void value(JsonBox::Value& v, int depth){
+					switch(peek()){
+						case '{':
+							{
+								v.setObject(JsonBox::Object());
+								auto& o = v.getObject();
+								members(depth, [&](const std::string& key){
+									value(o[key], depth + 1);
+								});
+							}break;
+						case '[':
+							{
+								v.setArray(JsonBox::Array());
+								auto& a = v.getArray();
+								elements(depth, [&](){
+									a.emplace_back();
+									value(a.back(), depth + 1);
+								});
+							}break;
+						case '"':
+							{
+								++m_pos;
+								std::string s;
+								string(s);
+								v.setString(s);
+							}break;
+						default:
+							if(literal("true")){
+								v.setBoolean(true);
+							}else if(literal("false")){
+								v.setBoolean(false);
+							}else if(literal("null")){
+								v.setNull();
+							}else{
+								number(v);
+							}
+							break;
+					}
+				}
+				void skip(int depth){
+					switch(peek()){
+						case '{':
+							members(depth, [&](const std::string&){
+								skip(depth + 1);
+							});
+							break;
+						case '[':
+							elements(depth, [&](){
+								skip(depth + 1);
+							});
+							break;
+						default:
+							{
+								JsonBox::Value ignored;
+								value(ignored, depth);
+							}break;
+					}
+				}
+				/**
+				 *  @brief integers without fraction or exponent that fit an int are INTEGER like JsonBox, the rest DOUBLE.
+				 */
+				void number(JsonBox::Value& v){
+					const auto begin = m_pos;
+					bool isInteger = true;
+					if(m_pos < m_end && *m_pos == '-'){
+						++m_pos;
+					}
+					while(m_pos < m_end && ((*m_pos >= '0' && *m_pos <= '9') || *m_pos == '.' || *m_pos == 'e' || *m_pos == 'E' || *m_pos == '+' || *m_pos == '-')){
+						isInteger = isInteger && *m_pos >= '0' && *m_pos <= '9';
+						++m_pos;
+					}
+					const std::string text(begin, m_pos);
+					if(text.empty() || text == "-"){
+						throw Unreadable{};
+					}
+					char* end = nullptr;
+					errno = 0;
+					if(isInteger){
+						const auto i = std::strtoll(text.c_str(), &end, 10);
+						if(errno == 0 && *end == '\0' && i >= std::numeric_limits<int>::min() && i <= std::numeric_limits<int>::max()){
+							v.setInteger(static_cast<int>(i));
+							return;
+						}
+						throw Unreadable{};
+					}
+					const auto d = std::strtod(text.c_str(), &end);
+					if(*end != '\0'){
+						throw Unreadable{};
+					}
+					v.setDouble(d);
+				}
+				/**
+				 *  @brief reads a string after the opening quote, \u escapes are written as utf-8.
+				 */
+				void string(std::string& s){
+					s.clear();
+					while(true){
+						if(m_pos >= m_end){
+							throw Unreadable{};
+						}
+						const auto c = *m_pos++;
+						if(c == '"'){
+							return;
+						}
+						if(c != '\\'){
+							s += c;
+							continue;
+						}
+						if(m_pos >= m_end){
+							throw Unreadable{};
+						}
+						switch(*m_pos++){
+							case '"': s += '"'; break;
+							case '\\': s += '\\'; break;
+							case '/': s += '/'; break;
+							case 'b': s += '\b'; break;
+							case 'f': s += '\f'; break;
+							case 'n': s += '\n'; break;
+							case 'r': s += '\r'; break;
+							case 't': s += '\t'; break;
+							case 'u': utf8(codePoint(), s); break;
+							default: throw Unreadable{};
+						}
+					}
+				}
+				std::uint32_t hex4(){
+					if(m_end - m_pos < 4){
+						throw Unreadable{};
+					}
+					std::uint32_t value = 0;
+					for(auto i=0;i<4;++i){
+						const auto c = *m_pos++;
+						value <<= 4;
+						if(c >= '0' && c <= '9'){
+							value |= c - '0';
+						}else if(c >= 'a' && c <= 'f'){
+							value |= c - 'a' + 10;
+						}else if(c >= 'A' && c <= 'F'){
+							value |= c - 'A' + 10;
+						}else{
+							throw Unreadable{};
+						}
+					}
+					return value;
+				}
+				std::uint32_t codePoint(){
+					const auto high = hex4();
+					if(high < 0xD800 || high > 0xDBFF){
+						return high;
+					}
+					if(!literal("\\u")){
+						throw Unreadable{};
+					}
+					const auto low = hex4();
+					if(low < 0xDC00 || low > 0xDFFF){
+						throw Unreadable{};
+					}
+					return 0x10000 + ((high - 0xD800) << 10) + (low - 0xDC00);
+				}
+				static void utf8(std::uint32_t cp, std::string& s) noexcept{
+					if(cp < 0x80){
+						s += static_cast<char>(cp);
+					}else if(cp < 0x800){
+						s += static_cast<char>(0xC0 | (cp >> 6));
+						s += static_cast<char>(0x80 | (cp & 0x3F));
+					}else if(cp < 0x10000){
+						s += static_cast<char>(0xE0 | (cp >> 12));
+						s += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+						s += static_cast<char>(0x80 | (cp & 0x3F));
+					}else{
+						s += static_cast<char>(0xF0 | (cp >> 18));
+						s += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+						s += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+						s += static_cast<char>(0x80 | (cp & 0x3F));
+					}
+				}
+				const char* m_pos;
+				const char* m_end;
+		};
+	} // namespace
+	DNA readFlowerDNA(const std::string& flower, const std::string& name){
+		std::vector<EvoAI::Genome> genomes;
+		try{
+			if(Reader(flower).flower(genomes)){
+				return DNA(std::move(genomes));
+			}
+		}catch(const Unreadable&){
+			FE_PROFILE_COUNT(JsonReaderFallbacks, 1);
+			JsonBox::Value v1;
+			v1.loadFromString(flower);
+			if(!v1["Flower"]["dna"].isNull()){
+				return DNA(v1["Flower"]["dna"].getObject());
+			}
+		}
+		throw std::invalid_argument("error, invalid " + name + ", could not parse data.");
+	}
+	JsonBox::Object readFlowerPetals(const std::string& flower){
+		JsonBox::Value petals;
+		try{
+			if(Reader(flower).petals(petals)){
+				return std::move(petals.getObject());
+			}
+		}catch(const Unreadable&){
+			FE_PROFILE_COUNT(JsonReaderFallbacks, 1);
+			JsonBox::Value v1;
+			v1.loadFromString(flower);
+			if(v1["Flower"]["petals"].isObject()){
+				return std::move(v1["Flower"]["petals"].getObject());
+			}
+		}
+		return JsonBox::Object();
+	}
+} // namespace fe
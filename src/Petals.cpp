@@ -1,4 +1,16 @@
 #include <Petals.hpp>
+#include <Platform.hpp>
+#include <RenderOptions.hpp>
+#include <ThreadPool.hpp>
+#include <Profile.hpp>
+#include <Trace.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <numeric>
 
 namespace fe{
 	Petals::Petals() noexcept
@@ -64,22 +76,352 @@ namespace fe{
 		numLayers = rhs.numLayers;
 		hasBloom = rhs.hasBloom;
 	}
+	namespace{
+		/**
+		 * @brief SoA inputs (radius, sin(P*angle), layer, bias) and outputs for CPPN::forwardBatch.
+		 */
+		class CPPNBatch final{
+			public:
+				/// inputs per task of the thread pool, a multiple of CPPN::batchSize so the chunks are the same.
+				static constexpr std::size_t parallelSize = 4 * CPPN::batchSize;
+			public:
+				CPPNBatch(int layer, float bias, std::size_t numThreads = 1) noexcept
+				: m_layer(static_cast<float>(layer))
+				, m_bias(bias)
+				, m_numThreads(numThreads){}
+				/**
+				 * @brief adds an input, returns its index.
+				 */
+				std::size_t push(float radius, float angle) noexcept{
+					m_radius.emplace_back(radius);
+					m_angle.emplace_back(angle);
+					return m_radius.size() - 1;
+				}
+				void run(const CPPN& nn) noexcept{
+					const auto count = m_radius.size();
+					m_layers.assign(count, m_layer);
+					m_biases.assign(count, m_bias);
+					for(auto& out:m_outputs){
+						out.resize(count);
+					}
+					const double* inputs[] = {m_radius.data(), m_angle.data(), m_layers.data(), m_biases.data()};
+					double* outputs[] = {m_outputs[0].data(), m_outputs[1].data(), m_outputs[2].data(), m_outputs[3].data()};
+					FE_PROFILE_COUNT(NNForward, count);
+					const auto numTasks = (count + parallelSize - 1) / parallelSize;
+					if(m_numThreads == 1 || numTasks <= 1 || !nn.isCompiled()){
+						nn.forwardBatch(inputs, outputs, count);
+						return;
+					}
+					// the tape is shared, every thread has its own values.
+					const CPPN& tape = nn;
+					getThreadPool().run(numTasks, m_numThreads, [&](std::size_t task){
+						thread_local std::vector<double> values;
+						values.resize(tape.getNumNodes() * CPPN::batchSize);
+						const auto end = std::min(count, (task + 1) * parallelSize);
+						for(auto start=task*parallelSize;start<end;start+=CPPN::batchSize){
+							const double* in[] = {inputs[0] + start, inputs[1] + start, inputs[2] + start, inputs[3] + start};
+							double* out[] = {outputs[0] + start, outputs[1] + start, outputs[2] + start, outputs[3] + start};
+							tape.evaluateBatch(in, out, std::min(CPPN::batchSize, end - start), values.data());
+						}
+					});
+				}
+				void clear() noexcept{
+					m_radius.clear();
+					m_angle.clear();
+				}
+				double output(std::size_t out, std::size_t index) const noexcept{
+					return m_outputs[out][index];
+				}
+				sf::Color color(std::size_t index) const noexcept{
+					return sf::Color(m_outputs[0][index] * 255, m_outputs[1][index] * 255, m_outputs[2][index] * 255, 255);
+				}
+			private:
+				double m_layer;
+				double m_bias;
+				/// 0 uses every thread of the pool
+				std::size_t m_numThreads;
+				std::vector<double> m_radius;
+				std::vector<double> m_angle;
+				std::vector<double> m_layers;
+				std::vector<double> m_biases;
+				std::array<std::vector<double>, 4> m_outputs;
+		};
+		/**
+		 * @brief samples the radius input (output 3) of an inner layer over (ray class, step).
+		 *
+		 * With tolerance 0 every required (class, step) is evaluated. Otherwise the required ones are
+		 * grouped in cells of coarseSize classes by coarseSize steps (classes are sorted by angle), the
+		 * corners and the center of each cell are evaluated, if the center is within tolerance of the
+		 * bilinear interpolation of the corners the rest of the cell is interpolated, if not the cell is
+		 * split in four until it only has corners.
+		 */
+		class PolarSampler final{
+			public:
+				/// classes and steps of the first cells.
+				static constexpr std::size_t coarseSize = 8;
+				/// cells with this many required or less are evaluated, sampling them costs more.
+				static constexpr std::size_t minCellRequired = 8;
+				/// CPPN with less weighted inputs in the tape (one per enabled connection) are evaluated, sampling them costs more.
+				static constexpr std::size_t minTapeInputs = 24;
+			public:
+				PolarSampler(std::size_t numClasses, std::size_t numSteps, float tolerance) noexcept
+				: m_numClasses(numClasses)
+				, m_numSteps(numSteps)
+				, m_tolerance(tolerance)
+				, m_state(numClasses * numSteps, State::Unused)
+				, m_values(numClasses * numSteps, 0.0)
+				, m_required(){}
+				/**
+				 * @brief index is class * numSteps + step.
+				 */
+				void require(std::size_t index) noexcept{
+					if(m_state[index] == State::Unused){
+						m_state[index] = State::Required;
+						m_required.emplace_back(index);
+					}
+				}
+				void run(const CPPN& nn, CPPNBatch& batch, const std::vector<float>& classAngles) noexcept{
+					if(m_tolerance <= 0.0f){
+						evaluate(nn, batch, classAngles, m_required);
+						return;
+					}
+					/**
+					 * @brief classes [c0, c1] and steps [s0, s1].
+					 */
+					struct Cell{
+						std::size_t c0;
+						std::size_t c1;
+						std::size_t s0;
+						std::size_t s1;
+					};
+					const auto numCellClasses = (m_numClasses + coarseSize - 1) / coarseSize;
+					const auto numCellSteps = (m_numSteps + coarseSize - 1) / coarseSize;
+					auto cellOf = [&](std::size_t index){
+						return (index / m_numSteps) / coarseSize * numCellSteps + (index % m_numSteps) / coarseSize;
+					};
+					std::vector<std::uint16_t> numCellRequired(numCellClasses * numCellSteps, 0);
+					for(auto index:m_required){
+						++numCellRequired[cellOf(index)];
+					}
+					std::vector<Cell> cells;
+					for(auto i=0u;i<numCellRequired.size();++i){
+						if(numCellRequired[i] > minCellRequired){
+							const auto c0 = (i / numCellSteps) * coarseSize;
+							const auto s0 = (i % numCellSteps) * coarseSize;
+							cells.push_back({c0, std::min(c0 + coarseSize, m_numClasses - 1), s0, std::min(s0 + coarseSize, m_numSteps - 1)});
+						}
+					}
+					/// required indices of cells where sampling would evaluate more than them.
+					std::vector<std::size_t> direct;
+					for(auto index:m_required){
+						if(numCellRequired[cellOf(index)] <= minCellRequired){
+							direct.emplace_back(index);
+						}
+					}
+					auto at = [this](std::size_t c, std::size_t s){
+						return c * m_numSteps + s;
+					};
+					auto forEachRequired = [&](const Cell& cell, auto&& fn){
+						for(auto c=cell.c0;c<=cell.c1;++c){
+							for(auto s=cell.s0;s<=cell.s1;++s){
+								if(m_state[at(c, s)] == State::Required){
+									fn(at(c, s));
+								}
+							}
+						}
+					};
+					std::vector<Cell> split;
+					std::vector<std::size_t> points;
+					while(!cells.empty() || !direct.empty()){
+						points.clear();
+						for(auto index:direct){
+							m_state[index] = State::Evaluated;
+							points.emplace_back(index);
+						}
+						direct.clear();
+						for(const auto& cell:cells){
+							const auto cm = (cell.c0 + cell.c1) / 2;
+							const auto sm = (cell.s0 + cell.s1) / 2;
+							for(auto index:{at(cell.c0, cell.s0), at(cell.c0, cell.s1), at(cell.c1, cell.s0), at(cell.c1, cell.s1), at(cm, sm)}){
+								if(m_state[index] != State::Evaluated){
+									m_state[index] = State::Evaluated;
+									points.emplace_back(index);
+								}
+							}
+						}
+						evaluate(nn, batch, classAngles, points);
+						split.clear();
+						for(const auto& cell:cells){
+							const auto cm = (cell.c0 + cell.c1) / 2;
+							const auto sm = (cell.s0 + cell.s1) / 2;
+							const auto v00 = m_values[at(cell.c0, cell.s0)];
+							const auto v01 = m_values[at(cell.c0, cell.s1)];
+							const auto v10 = m_values[at(cell.c1, cell.s0)];
+							const auto v11 = m_values[at(cell.c1, cell.s1)];
+							auto bilinear = [&](std::size_t c, std::size_t s){
+								const auto u = cell.c1 > cell.c0 ? static_cast<double>(c - cell.c0) / (cell.c1 - cell.c0):0.0;
+								const auto v = cell.s1 > cell.s0 ? static_cast<double>(s - cell.s0) / (cell.s1 - cell.s0):0.0;
+								return (v00 * (1.0 - v) + v01 * v) * (1.0 - u) + (v10 * (1.0 - v) + v11 * v) * u;
+							};
+							if(std::abs(m_values[at(cm, sm)] - bilinear(cm, sm)) <= m_tolerance){
+								for(auto c=cell.c0;c<=cell.c1;++c){
+									for(auto s=cell.s0;s<=cell.s1;++s){
+										if(m_state[at(c, s)] == State::Required){
+											m_values[at(c, s)] = bilinear(c, s);
+											m_state[at(c, s)] = State::Interpolated;
+										}
+									}
+								}
+								continue;
+							}
+							// a cell of 2x2 or less only has corners, they are evaluated.
+							const bool splitClasses = cell.c1 - cell.c0 >= 2;
+							const bool splitSteps = cell.s1 - cell.s0 >= 2;
+							if(!splitClasses && !splitSteps){
+								continue;
+							}
+							std::size_t numRequired = 0;
+							forEachRequired(cell, [&numRequired](std::size_t){ ++numRequired; });
+							// splitting evaluates the middle of the edges and the center of the parts.
+							if(numRequired <= minCellRequired){
+								forEachRequired(cell, [&direct](std::size_t index){ direct.emplace_back(index); });
+								continue;
+							}
+							const Cell parts[] = {
+								{cell.c0, splitClasses ? cm:cell.c1, cell.s0, splitSteps ? sm:cell.s1},
+								{cm, cell.c1, cell.s0, splitSteps ? sm:cell.s1},
+								{cell.c0, splitClasses ? cm:cell.c1, sm, cell.s1},
+								{cm, cell.c1, sm, cell.s1}
+							};
+							const bool isUsed[] = {true, splitClasses, splitSteps, splitClasses && splitSteps};
+							for(auto i=0u;i<4;++i){
+								bool hasRequired = false;
+								forEachRequired(parts[i], [&hasRequired](std::size_t){ hasRequired = true; });
+								if(isUsed[i] && hasRequired){
+									split.push_back(parts[i]);
+								}
+							}
+						}
+						std::swap(cells, split);
+					}
+				}
+				/**
+				 * @brief the radius input at index, it needs run.
+				 */
+				int get(std::size_t index) const noexcept{
+					return m_values[index];
+				}
+			private:
+				enum class State : std::uint8_t{
+					Unused,
+					Required,
+					Interpolated,
+					Evaluated
+				};
+				void evaluate(const CPPN& nn, CPPNBatch& batch, const std::vector<float>& classAngles, const std::vector<std::size_t>& indices) noexcept{
+					if(indices.empty()){
+						return;
+					}
+					batch.clear();
+					for(auto index:indices){
+						batch.push(index % m_numSteps, classAngles[index / m_numSteps]);
+					}
+					batch.run(nn);
+					for(auto i=0u;i<indices.size();++i){
+						m_values[indices[i]] = batch.output(3, i);
+						m_state[indices[i]] = State::Evaluated;
+					}
+				}
+			private:
+				std::size_t m_numClasses;
+				std::size_t m_numSteps;
+				float m_tolerance;
+				std::vector<State> m_state;
+				std::vector<double> m_values;
+				std::vector<std::size_t> m_required;
+		};
+		struct PolarTableKey final{
+			int originRadius;
+			int layerRadius;
+			float P;
+			int width;
+			int height;
+			float periodTolerance;
+			bool operator==(const PolarTableKey& rhs) const noexcept{
+				return originRadius == rhs.originRadius && layerRadius == rhs.layerRadius
+					&& P == rhs.P && width == rhs.width && height == rhs.height
+					&& periodTolerance == rhs.periodTolerance;
+			}
+		};
+		/**
+		 * @brief least recently used cache of PolarTable limited by memory.
+		 */
+		struct PolarTableCache final{
+			struct Entry{
+				PolarTableKey key;
+				std::shared_ptr<const priv::PolarTable> table;
+				std::size_t bytes;
+				std::uint64_t lastUse;
+			};
+			std::mutex mutex;
+			std::vector<Entry> entries;
+			std::size_t bytes{0};
+			/// 1/8 of the heap (2.5 MB of the 20 MB wasm heap, the tables of a radius 128 flower), 8 MB natively
+			std::size_t limit{platform::getCacheBudget(8, 8 * 1024 * 1024)};
+			std::uint64_t clock{0};
+			/**
+			 * @brief evicts least recently used tables until extra bytes fit in the limit.
+			 */
+			void evict(std::size_t extra) noexcept{
+				while(!entries.empty() && bytes + extra > limit){
+					auto lru = std::min_element(std::begin(entries), std::end(entries), [](const Entry& a, const Entry& b){
+						return a.lastUse < b.lastUse;
+					});
+					bytes -= lru->bytes;
+					entries.erase(lru);
+				}
+			}
+			void add(const PolarTableKey& key, const std::shared_ptr<const priv::PolarTable>& table) noexcept{
+				auto it = std::find_if(std::begin(entries), std::end(entries), [&key](const Entry& e){
+					return e.key == key;
+				});
+				if(it != std::end(entries)){
+					return;
+				}
+				const auto tableBytes = table->getSizeInBytes();
+				if(tableBytes > limit){
+					return;
+				}
+				evict(tableBytes);
+				entries.push_back({key, table, tableBytes, ++clock});
+				bytes += tableBytes;
+			}
+		};
+		PolarTableCache& polarTableCache() noexcept{
+			static PolarTableCache cache;
+			return cache;
+		}
+	} // namespace
 	namespace priv{
-		std::vector<double> queryNN(EvoAI::NeuralNetwork& nn, Petals& petals, const sf::Vector2f& pos, int currentRadius, int currentLayer) noexcept{
+		std::array<double, 4> queryNN(const CPPN& nn, Petals& petals, const sf::Vector2f& pos, int currentRadius, int currentLayer) noexcept{
 			const auto& origin = sf::Vector2f(petals.radius, petals.radius);
 			float angle = std::sin(petals.P*Math::directedAngle(pos,origin, origin));
-			auto res = nn.forward({static_cast<float>(currentRadius), angle, static_cast<float>(currentLayer), petals.bias});
-			nn.reset();
+			FE_PROFILE_COUNT(NNForward, 1);
+			const double inputs[] = {static_cast<float>(currentRadius), angle, static_cast<float>(currentLayer), petals.bias};
+			std::array<double, 4> res;
+			nn.forward(inputs, res.data());
 			return res;
 		}
-		void setColorAndCut(const sf::Vector2f& pos, EvoAI::NeuralNetwork& nn, Petals& petals, int currentRadius, int currentLayer) noexcept{
+		void setColorAndCut(const sf::Vector2f& pos, const CPPN& nn, Petals& petals, int currentRadius, int currentLayer) noexcept{
 			const auto size = petals.image.getSize();
 			const auto& bounds = sf::FloatRect(0,0,size.x,size.y);
 			const auto& origin = sf::Vector2f(petals.radius,petals.radius);
 			const float angle = std::sin(petals.P*Math::directedAngle(pos, origin, origin));
 			auto direction = Math::normalize(pos - origin);
-			auto res = nn.forward({0.0f, angle, static_cast<float>(currentLayer), petals.bias});
-			nn.reset();
+			FE_PROFILE_COUNT(NNForward, 1);
+			const double inputs[] = {0.0f, angle, static_cast<float>(currentLayer), petals.bias};
+			std::array<double, 4> res;
+			nn.forward(inputs, res.data());
 			float rMax = std::min(std::abs(res[3] * currentRadius),static_cast<double>(currentRadius));
 			auto newPos = origin + direction;
 			auto halfLayerSize = petals.numLayers/2;
@@ -91,11 +433,12 @@ namespace fe{
 				if(bounds.contains(newPos)){
 					res = queryNN(nn,petals,newPos,currentRadius,currentLayer);
 					petals.image.setPixel(newPos.x,newPos.y, sf::Color(res[0] * 255,res[1] * 255, res[2] * 255, 255));
+					FE_PROFILE_COUNT(PixelsWritten, 1);
 				}
 				newPos += direction;
 			}
 		}
-		void EightWaySymmetricSetColor(const sf::Vector2f& origin, const sf::Vector2f& r, Petals& petals, EvoAI::NeuralNetwork& nn, int currentRadius, int currentLayer) noexcept{
+		void EightWaySymmetricSetColor(const sf::Vector2f& origin, const sf::Vector2f& r, Petals& petals, const CPPN& nn, int currentRadius, int currentLayer) noexcept{
 			setColorAndCut(sf::Vector2f(r.x + origin.x, r.y + origin.y), nn, petals, currentRadius, currentLayer);
 			setColorAndCut(sf::Vector2f(r.x + origin.x, -r.y + origin.y), nn, petals, currentRadius, currentLayer);
 			setColorAndCut(sf::Vector2f(-r.x + origin.x, -r.y + origin.y), nn, petals, currentRadius, currentLayer);
@@ -106,7 +449,8 @@ namespace fe{
 			setColorAndCut(sf::Vector2f(-r.y + origin.x, -r.x + origin.y), nn, petals, currentRadius, currentLayer);
 			setColorAndCut(sf::Vector2f(-r.y + origin.x, r.x + origin.y), nn, petals, currentRadius, currentLayer);
 		}
-		void drawPetals(Petals& petals, EvoAI::NeuralNetwork& nn,int currentRadius, int currentLayer) noexcept{
+		void drawPetalsRayMarch(Petals& petals, const CPPN& nn,int currentRadius, int currentLayer) noexcept{
+			FE_PROFILE_SCOPE(DrawPetals);
 			int x = 0;
 			int y = currentRadius;
 			int d = 1-y;
@@ -123,15 +467,400 @@ namespace fe{
 				EightWaySymmetricSetColor(origin,sf::Vector2f(x,y),petals,nn,currentRadius,currentLayer);
 			}
 		}
+		PolarTable::PolarTable(int originRadius, int layerRadius, float P, int width, int height, float periodTolerance) noexcept
+		: angles()
+		, classes()
+		, classAngles()
+		, firstRow(0)
+		, rows()
+		, pixels()
+		, candidates(){
+			const auto& origin = sf::Vector2f(originRadius, originRadius);
+			// the rays of the midpoint circle walk in the order drawPetalsRayMarch marches them.
+			std::vector<sf::Vector2i> offsets;
+			auto addOctants = [&](int x, int y){
+				offsets.insert(std::end(offsets), {{x, y}, {x, -y}, {-x, -y}, {-x, y}, {y, x}, {y, -x}, {-y, -x}, {-y, x}});
+			};
+			int x = 0;
+			int y = layerRadius;
+			int d = 1-y;
+			addOctants(x, y);
+			while(x<=y){
+				if(d<=0){
+					d -= 2*x+1;
+				}else{
+					d += 2*y+1;
+					--y;
+				}
+				++x;
+				addOctants(x, y);
+			}
+			// a ray marched twice writes the same pixels again, it keeps the place of its last march.
+			std::vector<std::size_t> order(offsets.size());
+			std::iota(std::begin(order), std::end(order), 0);
+			std::sort(std::begin(order), std::end(order), [&](std::size_t a, std::size_t b){
+				const auto& oa = offsets[a];
+				const auto& ob = offsets[b];
+				return oa.x < ob.x || (oa.x == ob.x && (oa.y < ob.y || (oa.y == ob.y && a > b)));
+			});
+			order.erase(std::unique(std::begin(order), std::end(order), [&](std::size_t a, std::size_t b){
+				return offsets[a] == offsets[b];
+			}), std::end(order));
+			std::sort(std::begin(order), std::end(order));
+			/**
+			 * @brief a pixel written by a ray at a step.
+			 */
+			struct Sample{
+				int y;
+				int x;
+				Candidate candidate;
+			};
+			// the same points the marcher samples, step r is at origin + direction * (r + 1).
+			const auto& bounds = sf::FloatRect(0, 0, width, height);
+			std::vector<Sample> samples;
+			angles.reserve(order.size());
+			for(auto i:order){
+				const auto pos = origin + sf::Vector2f(offsets[i].x, offsets[i].y);
+				const auto direction = Math::normalize(pos - origin);
+				const auto ray = static_cast<std::uint16_t>(angles.size());
+				angles.emplace_back(std::sin(P*Math::directedAngle(pos, origin, origin)));
+				auto samplePos = origin + direction;
+				for(auto step=0;step<=layerRadius;++step){
+					if(bounds.contains(samplePos)){
+						samples.push_back({static_cast<int>(samplePos.y), static_cast<int>(samplePos.x), {ray, static_cast<std::int16_t>(step)}});
+					}
+					samplePos += direction;
+				}
+			}
+			// later rays and steps overwrite the pixel so they go first.
+			std::sort(std::begin(samples), std::end(samples), [](const Sample& a, const Sample& b){
+				if(a.y != b.y){
+					return a.y < b.y;
+				}
+				if(a.x != b.x){
+					return a.x < b.x;
+				}
+				if(a.candidate.ray != b.candidate.ray){
+					return a.candidate.ray > b.candidate.ray;
+				}
+				return a.candidate.step > b.candidate.step;
+			});
+			/**
+			 * @brief groups the rays by input, a class spans at most tolerance and gets the angle in the middle.
+			 */
+			auto makeClasses = [&](float tolerance){
+				std::vector<std::uint16_t> byAngle(angles.size());
+				std::iota(std::begin(byAngle), std::end(byAngle), 0);
+				std::stable_sort(std::begin(byAngle), std::end(byAngle), [&](std::uint16_t a, std::uint16_t b){
+					return angles[a] < angles[b];
+				});
+				classes.assign(angles.size(), 0);
+				classAngles.clear();
+				for(auto first=0u;first<byAngle.size();){
+					auto last = first;
+					while(last + 1 < byAngle.size() && angles[byAngle[last + 1]] - angles[byAngle[first]] <= tolerance){
+						++last;
+					}
+					for(auto i=first;i<=last;++i){
+						classes[byAngle[i]] = static_cast<std::uint16_t>(classAngles.size());
+					}
+					const auto lo = angles[byAngle[first]];
+					const auto hi = angles[byAngle[last]];
+					classAngles.emplace_back(lo == hi ? lo:lo + (hi - lo) * 0.5f);
+					first = last + 1;
+				}
+			};
+			makeClasses(periodTolerance);
+			// without a period (P not an integer) the tolerance only moves rays, keep the exact classes.
+			if(periodTolerance > 0.0f && classAngles.size() * 2 > angles.size()){
+				makeClasses(0.0f);
+			}
+			firstRow = samples.empty() ? 0:samples.front().y;
+			rows.emplace_back(0);
+			for(auto first=std::begin(samples);first != std::end(samples);){
+				while(firstRow + static_cast<int>(rows.size()) - 1 < first->y){
+					rows.emplace_back(static_cast<std::uint32_t>(pixels.size()));
+				}
+				auto last = first;
+				while(last != std::end(samples) && last->y == first->y && last->x == first->x){
+					candidates.emplace_back(last->candidate);
+					++last;
+				}
+				Pixel pixel;
+				pixel.x = static_cast<std::uint16_t>(first->x);
+				pixel.numCandidates = static_cast<std::uint16_t>(std::distance(first, last));
+				pixel.firstCandidate = static_cast<std::uint32_t>(candidates.size() - pixel.numCandidates);
+				pixels.emplace_back(pixel);
+				first = last;
+			}
+			if(!samples.empty()){
+				rows.emplace_back(static_cast<std::uint32_t>(pixels.size()));
+			}
+			angles.shrink_to_fit();
+			classAngles.shrink_to_fit();
+			pixels.shrink_to_fit();
+			candidates.shrink_to_fit();
+		}
+		std::size_t PolarTable::getSizeInBytes() const noexcept{
+			return sizeof(PolarTable)
+				+ angles.capacity() * sizeof(float)
+				+ classes.capacity() * sizeof(std::uint16_t)
+				+ classAngles.capacity() * sizeof(float)
+				+ rows.capacity() * sizeof(std::uint32_t)
+				+ pixels.capacity() * sizeof(Pixel)
+				+ candidates.capacity() * sizeof(Candidate);
+		}
+		std::shared_ptr<const PolarTable> getPolarTable(const Petals& petals, int layerRadius, float periodTolerance) noexcept{
+			const auto size = petals.image.getSize();
+			const PolarTableKey key{petals.radius, layerRadius, petals.P, static_cast<int>(size.x), static_cast<int>(size.y), periodTolerance};
+			auto& cache = polarTableCache();
+			{
+				std::lock_guard lock(cache.mutex);
+				auto it = std::find_if(std::begin(cache.entries), std::end(cache.entries), [&key](const auto& e){
+					return e.key == key;
+				});
+				if(it != std::end(cache.entries)){
+					it->lastUse = ++cache.clock;
+					return it->table;
+				}
+			}
+			auto table = std::make_shared<const PolarTable>(key.originRadius, key.layerRadius, key.P, key.width, key.height, key.periodTolerance);
+			std::lock_guard lock(cache.mutex);
+			cache.add(key, table);
+			return table;
+		}
+		void setPolarTableCacheLimit(std::size_t bytes) noexcept{
+			auto& cache = polarTableCache();
+			std::lock_guard lock(cache.mutex);
+			cache.limit = bytes;
+			cache.evict(0);
+		}
+		void clearPolarTables() noexcept{
+			auto& cache = polarTableCache();
+			std::lock_guard lock(cache.mutex);
+			cache.entries.clear();
+			cache.bytes = 0;
+		}
+		namespace{
+			/// rows of the tiles rendered by the thread pool.
+			constexpr int tileRows = 16;
+			/**
+			 * @brief drawPetals for currentRadius > 0, pixels with occupancy[y * width + x] != 0 are skipped
+			 *        and the written ones are set to 1, occupancy can be nullptr.
+			 */
+			void rasterizePetals(Petals& petals, const CPPN& nn, int currentRadius, int currentLayer, std::uint8_t* occupancy) noexcept{
+				FE_PROFILE_SCOPE(DrawPetals);
+				const auto options = getRenderOptions();
+				const auto numThreads = static_cast<std::size_t>(options.numThreads);
+				const auto table = getPolarTable(petals, currentRadius, options.periodTolerance);
+				const auto& origin = sf::Vector2f(petals.radius,petals.radius);
+				const bool isInnerLayer = currentLayer >= petals.numLayers/2;
+				const auto numClasses = table->classAngles.size();
+				CPPNBatch batch(currentLayer, petals.bias, numThreads);
+				CPPNBatch colorBatch(currentLayer, petals.bias, numThreads);
+				for(auto angle:table->classAngles){
+					batch.push(0.0f, angle);
+					if(!isInnerLayer){
+						// the radius input is constant along the ray so is the color.
+						colorBatch.push(currentRadius, angle);
+					}
+				}
+				batch.run(nn);
+				if(!isInnerLayer){
+					colorBatch.run(nn);
+				}
+				std::vector<float> rMax(numClasses);
+				std::vector<sf::Color> classColors(isInnerLayer ? 0:numClasses);
+				float maxReach = -1.0f;
+				for(auto i=0u;i<numClasses;++i){
+					rMax[i] = std::min(std::abs(batch.output(3, i) * currentRadius),static_cast<double>(currentRadius));
+					if(rMax[i] > maxReach){
+						maxReach = rMax[i];
+					}
+					if(!isInnerLayer){
+						classColors[i] = colorBatch.color(i);
+					}
+				}
+				if(maxReach < 0.0f){
+					return;
+				}
+				// farthest sample is at step floor(maxReach) + 1
+				const int reach = static_cast<int>(maxReach) + 1;
+				const int minX = static_cast<int>(origin.x) - reach - 1;
+				const int maxX = static_cast<int>(origin.x) + reach;
+				const int minY = std::max(table->firstRow, static_cast<int>(origin.y) - reach - 1);
+				const int maxY = std::min(table->firstRow + static_cast<int>(table->rows.size()) - 2, static_cast<int>(origin.y) + reach);
+				const auto numSteps = static_cast<std::size_t>(currentRadius) + 1;
+				/**
+				 * @brief a pixel of an inner layer waiting for its radius input and color.
+				 */
+				struct Hit{
+					int x;
+					int y;
+					std::uint16_t rayClass;
+					/// index in samples (class * numSteps + step), then of the color in colors[rayClass]
+					std::size_t index;
+				};
+				const auto width = static_cast<std::size_t>(petals.image.getSize().x);
+				// tiles of rows write disjoint pixels, their hits are joined in row order.
+				const auto numTiles = static_cast<std::size_t>((maxY - minY) / tileRows + 1);
+				std::vector<std::vector<Hit>> tileHits(numTiles);
+				getThreadPool().run(numTiles, numThreads, [&](std::size_t tile){
+					auto& hits = tileHits[tile];
+					const auto lastY = std::min(maxY, minY + static_cast<int>((tile + 1) * tileRows) - 1);
+					for(auto py=minY+static_cast<int>(tile*tileRows);py<=lastY;++py){
+						const auto row = py - table->firstRow;
+						auto* occupancyRow = occupancy ? occupancy + py * width:nullptr;
+						for(auto p=table->rows[row];p<table->rows[row+1];++p){
+							const auto& pixel = table->pixels[p];
+							if(pixel.x < minX || pixel.x > maxX){
+								continue;
+							}
+							if(occupancyRow && occupancyRow[pixel.x]){
+								FE_PROFILE_COUNT(PixelsOccluded, 1);
+								continue;
+							}
+							const auto* first = table->candidates.data() + pixel.firstCandidate;
+							const auto* last = first + pixel.numCandidates;
+							// candidates are in reverse marching order, the first that reaches the pixel writes it last.
+							const auto* best = std::find_if(first, last, [&](const PolarTable::Candidate& c){
+								return c.step <= rMax[table->classes[c.ray]];
+							});
+							if(best == last){
+								continue;
+							}
+							const auto rayClass = table->classes[best->ray];
+							if(occupancyRow){
+								occupancyRow[pixel.x] = 1;
+							}
+							if(isInnerLayer){
+								hits.push_back({pixel.x, py, rayClass, rayClass * numSteps + static_cast<std::size_t>(best->step)});
+							}else{
+								petals.image.setPixel(pixel.x, py, classColors[rayClass]);
+								FE_PROFILE_COUNT(PixelsWritten, 1);
+							}
+						}
+					}
+				});
+				std::vector<Hit> hits;
+				for(auto& tile:tileHits){
+					hits.insert(std::end(hits), std::begin(tile), std::end(tile));
+				}
+				if(hits.empty()){
+					return;
+				}
+				// inner layers: the radius input comes from the CPPN (output 3) sampled along each class,
+				// then the color for that radius once per class and radius.
+				// tapes with few weighted inputs are cheaper to evaluate than to sample.
+				const bool isSampled = !nn.isCompiled() || nn.getInputs().size() >= PolarSampler::minTapeInputs;
+				PolarSampler sampler(numClasses, numSteps, isSampled ? options.sampleTolerance:0.0f);
+				for(const auto& hit:hits){
+					sampler.require(hit.index);
+				}
+				sampler.run(nn, batch, table->classAngles);
+				/// colors by radius input for each class
+				std::vector<std::vector<std::pair<int, sf::Color>>> colors(numClasses);
+				// colors of (class, radius) that are not in the memo yet, in colorBatch order
+				std::vector<std::pair<std::uint16_t, std::size_t>> missing;
+				colorBatch.clear();
+				for(auto& hit:hits){
+					const int radius = sampler.get(hit.index);
+					auto& memo = colors[hit.rayClass];
+					auto it = std::find_if(std::begin(memo), std::end(memo), [radius](const auto& c){
+						return c.first == radius;
+					});
+					hit.index = std::distance(std::begin(memo), it);
+					if(it == std::end(memo)){
+						memo.emplace_back(radius, sf::Color::Transparent);
+						colorBatch.push(radius, table->classAngles[hit.rayClass]);
+						missing.emplace_back(hit.rayClass, hit.index);
+					}
+				}
+				colorBatch.run(nn);
+				for(auto i=0u;i<missing.size();++i){
+					colors[missing[i].first][missing[i].second].second = colorBatch.color(i);
+				}
+				for(const auto& hit:hits){
+					petals.image.setPixel(hit.x, hit.y, colors[hit.rayClass][hit.index].second);
+				}
+				FE_PROFILE_COUNT(PixelsWritten, hits.size());
+			}
+		} // namespace
+		void drawPetals(Petals& petals, const CPPN& nn, int currentRadius, int currentLayer) noexcept{
+			if(currentRadius <= 0){
+				drawPetalsRayMarch(petals, nn, currentRadius, currentLayer);
+				return;
+			}
+			rasterizePetals(petals, nn, currentRadius, currentLayer, nullptr);
+		}
+		void drawPetalsFrontToBack(Petals& petals, const CPPN& nn, int currentRadius, int currentLayer, std::vector<std::uint8_t>& occupancy) noexcept{
+			const auto size = petals.image.getSize();
+			occupancy.resize(static_cast<std::size_t>(size.x) * static_cast<std::size_t>(size.y), 0);
+			rasterizePetals(petals, nn, currentRadius, currentLayer, occupancy.data());
+		}
+		void drawAllPetals(Petals& petals, const CPPN& nn) noexcept{
+			std::vector<int> radii;
+			for(auto r = petals.radius, layer = petals.numLayers;layer>=0;--layer){
+				radii.emplace_back(r);
+				r /= 2;
+			}
+			// radii[i] is the radius of layer numLayers - i, a layer is covered by the layers after it
+			// so they are drawn first and the pixels they own are skipped.
+			std::vector<std::uint8_t> occupancy;
+			for(auto i = static_cast<int>(radii.size()) - 1;i>=0;--i){
+				if(radii[i] > 0){
+					drawPetalsFrontToBack(petals, nn, radii[i], petals.numLayers - i, occupancy);
+				}
+			}
+			// layers without radius use the marcher and they are on top.
+			for(auto i=0u;i<radii.size();++i){
+				if(radii[i] <= 0){
+					drawPetalsRayMarch(petals, nn, radii[i], petals.numLayers - i);
+				}
+			}
+		}
 		void drawTrunk(Petals& petals) noexcept{
+			FE_PROFILE_SCOPE(DrawTrunk);
 			const auto& origin = sf::Vector2f(petals.radius,petals.radius);
 			const auto& size = petals.image.getSize();
 			for(auto y=origin.y;y<size.y;++y){
 				petals.image.setPixel(origin.x-1,y,sf::Color::Green);
 				petals.image.setPixel(origin.x,y,sf::Color::Green);
 				petals.image.setPixel(origin.x+1,y,sf::Color::Green);
+				FE_PROFILE_COUNT(PixelsWritten, 3);
 			}
 		}
+		bool RasterDiff::isWithin(const RasterTolerance& tolerance) const noexcept{
+			return coveredPixels < tolerance.minCoveredPixels
+				|| (coverage <= tolerance.coverage && meanColorError <= tolerance.meanColorError);
+		}
+		RasterDiff compareRasters(const Image& reference, const Image& other) noexcept{
+			const auto& a = reference.imageData;
+			const auto& b = other.imageData;
+			const auto size = std::min(a.size(), b.size());
+			std::size_t covered = 0;
+			std::size_t mismatched = 0;
+			std::size_t both = 0;
+			double colorError = 0.0;
+			for(auto i=0u;i+3<size;i+=4){
+				const bool inA = a[i+3] != 0;
+				const bool inB = b[i+3] != 0;
+				covered += inA;
+				if(inA != inB){
+					++mismatched;
+				}else if(inA){
+					++both;
+					for(auto c=0u;c<3;++c){
+						colorError += std::abs(static_cast<int>(a[i+c]) - static_cast<int>(b[i+c]));
+					}
+				}
+			}
+			RasterDiff diff;
+			diff.coveredPixels = covered;
+			diff.coverage = covered ? static_cast<double>(mismatched) / covered:(mismatched ? 1.0:0.0);
+			diff.meanColorError = both ? colorError / (both * 3):0.0;
+			return diff;
+		}
 	}//priv/
 	int getTimesDivisibleBy(int val, int divisor) noexcept{
 		int count = 0;
@@ -146,7 +875,20 @@ namespace fe{
 		return count;
 	}
 	void drawLayer(Petals& petals, EvoAI::Genome& g, int layer, bool applyLayeredRadiusScaling) noexcept{
-		auto nn = EvoAI::Genome::makePhenotype(g);
+		auto nn = getCPPN(g);
+		drawLayer(petals, *nn, layer, applyLayeredRadiusScaling);
+	}
+	void draw(Petals::Type t, Petals& petals, EvoAI::Genome& g) noexcept{
+		if(t == Petals::Type::Trunk){
+			FE_TRACE_SPAN_ARG("draw", "type", static_cast<int>(t));
+			priv::drawTrunk(petals);
+			return;
+		}
+		auto nn = getCPPN(g);
+		draw(t, petals, *nn);
+	}
+	void drawLayer(Petals& petals, const CPPN& nn, int layer, bool applyLayeredRadiusScaling) noexcept{
+		FE_TRACE_SPAN_ARG("drawLayer", "layer", layer);
 		auto r = petals.radius;
 		if(applyLayeredRadiusScaling){
 			for(auto i = petals.numLayers;i>layer;--i){
@@ -155,30 +897,19 @@ namespace fe{
 		}
 		priv::drawPetals(petals, nn, r, layer);
 	}
-	void draw(Petals::Type t, Petals& petals, EvoAI::Genome& g) noexcept{
+	void draw(Petals::Type t, Petals& petals, const CPPN& nn) noexcept{
+		FE_TRACE_SPAN_ARG("draw", "type", static_cast<int>(t));
 		switch(t){
 			case Petals::Type::Trunk:
 				priv::drawTrunk(petals);
 				break;
 			case Petals::Type::Petals:
-				{
-					auto nn = EvoAI::Genome::makePhenotype(g);
-					auto r = petals.radius;
-					for(auto layer = petals.numLayers;layer>=0;--layer){
-						priv::drawPetals(petals,nn,r,layer);
-						r /= 2;
-					}
-				}break;
+				priv::drawAllPetals(petals, nn);
+				break;
 			case Petals::Type::TrunkAndPetals:
-				{
-					priv::drawTrunk(petals);
-					auto nn = EvoAI::Genome::makePhenotype(g);
-					auto r = petals.radius;
-					for(auto layer = petals.numLayers;layer>=0;--layer){
-						priv::drawPetals(petals,nn,r,layer);
-						r /= 2;
-					}
-				}break;
+				priv::drawTrunk(petals);
+				priv::drawAllPetals(petals, nn);
+				break;
 		}
 	}
 }
@@ -0,0 +1,86 @@
+#include <Profile.hpp>
+
+#include <array>
+#include <atomic>
+
+namespace fe::profile{
+	namespace{
+		constexpr auto numCounters = static_cast<std::size_t>(Counter::Count);
+		constexpr auto numTimers = static_cast<std::size_t>(Timer::Count);
+		constexpr std::array<const char*, numCounters> counterNames{
+			"nnForward",
+			"pixelsWritten",
+			"pixelsOccluded",
+			"contourPoints",
+			"simplifiedPoints",
+			"vertices",
+			"faces",
+			"pngBytes",
+			"base64Bytes",
+			"jsonBytes",
+			"cppnCacheHits",
+			"cppnCacheMisses",
+			"jsonReaderFallbacks"
+		};
+		constexpr std::array<const char*, numTimers> timerNames{
+			"drawPetals",
+			"drawTrunk",
+			"findContour",
+			"simplifyContour",
+			"petalLayer",
+			"normalMap",
+			"encodePng",
+			"base64",
+			"gltfToJson",
+			"gltfToJsonStr"
+		};
+		struct TimerData{
+			std::atomic<std::uint64_t> calls{0};
+			std::atomic<std::uint64_t> ns{0};
+		};
+		std::array<std::atomic<std::uint64_t>, numCounters> counters{};
+		std::array<TimerData, numTimers> timers{};
+	} // namespace
+	void count(Counter c, std::uint64_t n) noexcept{
+		counters[static_cast<std::size_t>(c)].fetch_add(n, std::memory_order_relaxed);
+	}
+	void addTime(Timer t, std::uint64_t ns) noexcept{
+		auto& timer = timers[static_cast<std::size_t>(t)];
+		timer.calls.fetch_add(1, std::memory_order_relaxed);
+		timer.ns.fetch_add(ns, std::memory_order_relaxed);
+	}
+	ScopedTimer::ScopedTimer(Timer t) noexcept
+	: m_timer(t)
+	, m_start(std::chrono::steady_clock::now()){}
+	ScopedTimer::~ScopedTimer() noexcept{
+		auto elapsed = std::chrono::steady_clock::now() - m_start;
+		addTime(m_timer, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	}
+	JsonBox::Value toJson() noexcept{
+		JsonBox::Object o;
+		o["enabled"] = JsonBox::Value(isEnabled());
+		JsonBox::Object t;
+		for(auto i=0u;i<numTimers;++i){
+			JsonBox::Object timer;
+			timer["calls"] = JsonBox::Value(static_cast<double>(timers[i].calls.load(std::memory_order_relaxed)));
+			timer["ms"] = JsonBox::Value(static_cast<double>(timers[i].ns.load(std::memory_order_relaxed)) / 1.0e6);
+			t[timerNames[i]] = JsonBox::Value(timer);
+		}
+		o["timers"] = JsonBox::Value(t);
+		JsonBox::Object c;
+		for(auto i=0u;i<numCounters;++i){
+			c[counterNames[i]] = JsonBox::Value(static_cast<double>(counters[i].load(std::memory_order_relaxed)));
+		}
+		o["counters"] = JsonBox::Value(c);
+		return JsonBox::Value(o);
+	}
+	void reset() noexcept{
+		for(auto& c:counters){
+			c.store(0, std::memory_order_relaxed);
+		}
+		for(auto& t:timers){
+			t.calls.store(0, std::memory_order_relaxed);
+			t.ns.store(0, std::memory_order_relaxed);
+		}
+	}
+} // namespace fe::profile
@@ -0,0 +1,116 @@
+#include <Random.hpp>
+
+#include <chrono>
+#include <utility>
+
+#include <EvoAI/Utils/RandomUtils.hpp>
+
+namespace fe{
+	namespace{
+		constexpr std::uint64_t golden = 0x9E3779B97F4A7C15ull;
+		/**
+		 *  @brief SplitMix64 finalizer.
+		 */
+		std::uint64_t mix(std::uint64_t z) noexcept{
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+		std::mutex& evoaiMutex() noexcept{
+			static std::mutex mutex;
+			return mutex;
+		}
+		std::mutex& seedMutex() noexcept{
+			static std::mutex mutex;
+			return mutex;
+		}
+		/// seed given to setSeed, guarded by seedMutex.
+		std::optional<std::uint64_t> fixedSeed;
+		/// seed of the outermost request of the thread.
+		thread_local std::uint64_t requestSeed = 0;
+		thread_local int requestDepth = 0;
+		/// EvoAIRandom of the current request, each one seeds EvoAI::randomGen() from its own sub stream.
+		thread_local std::uint64_t evoaiUses = 0;
+		thread_local int evoaiDepth = 0;
+	} // namespace
+	Random::Random(std::uint64_t seed, std::uint64_t stream) noexcept
+	: m_key(mix(seed ^ mix(stream + golden)))
+	, m_counter(0){}
+	Random Random::split(std::uint64_t stream) const noexcept{
+		return Random(m_key, stream);
+	}
+	std::uint64_t Random::next() noexcept{
+		return mix(m_key + ++m_counter * golden);
+	}
+	int Random::random(int min, int max) noexcept{
+		if(min > max){
+			std::swap(min, max);
+		}
+		const auto range = static_cast<std::uint64_t>(static_cast<std::int64_t>(max) - min) + 1;
+		// 32 bits multiply shift, range is at most 2^32
+		const auto offset = ((next() >> 32) * range) >> 32;
+		return static_cast<int>(static_cast<std::int64_t>(min) + static_cast<std::int64_t>(offset));
+	}
+	float Random::random(float min, float max) noexcept{
+		if(min > max){
+			std::swap(min, max);
+		}
+		const auto unit = static_cast<float>(next() >> 40) * (1.0f / 16777216.0f);
+		return min + (max - min) * unit;
+	}
+	double Random::random(double min, double max) noexcept{
+		if(min > max){
+			std::swap(min, max);
+		}
+		const auto unit = static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+		return min + (max - min) * unit;
+	}
+	bool Random::random(double rate) noexcept{
+		return random(0.0, 1.0) < rate;
+	}
+	RandomRequest::RandomRequest() noexcept
+	: m_seed(requestSeed){
+		if(requestDepth++ > 0){
+			return;
+		}
+		m_seed = fe::getSeed().value_or(std::chrono::steady_clock::now().time_since_epoch().count());
+		requestSeed = m_seed;
+		evoaiUses = 0;
+	}
+	RandomRequest::~RandomRequest(){
+		if(--requestDepth == 0){
+			requestSeed = 0;
+		}
+	}
+	std::uint64_t RandomRequest::getSeed() const noexcept{
+		return m_seed;
+	}
+	EvoAIRandom::EvoAIRandom() noexcept
+	: m_lock(){
+		if(evoaiDepth++ > 0){
+			return;
+		}
+		m_lock = std::unique_lock(evoaiMutex());
+		if(requestDepth > 0){
+			EvoAI::randomGen().setSeed(getRandom(RandomStream::EvoAI, evoaiUses++).next());
+		}
+	}
+	EvoAIRandom::~EvoAIRandom(){
+		--evoaiDepth;
+	}
+	void setSeed(std::uint64_t seed) noexcept{
+		std::lock_guard lock(seedMutex());
+		fixedSeed = seed;
+	}
+	void clearSeed() noexcept{
+		std::lock_guard lock(seedMutex());
+		fixedSeed.reset();
+	}
+	std::optional<std::uint64_t> getSeed() noexcept{
+		std::lock_guard lock(seedMutex());
+		return fixedSeed;
+	}
+	Random getRandom(RandomStream stream, std::uint64_t index) noexcept{
+		return Random(requestSeed, static_cast<std::uint64_t>(stream)).split(index);
+	}
+} // namespace fe
@@ -0,0 +1,47 @@
+#include <RenderOptions.hpp>
+
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace fe{
+	namespace{
+		std::mutex& optionsMutex() noexcept{
+			static std::mutex mutex;
+			return mutex;
+		}
+		RenderOptions& currentOptions() noexcept{
+			static RenderOptions options;
+			return options;
+		}
+	} // namespace
+	RenderOptions::RenderOptions(JsonBox::Object o)
+	: periodTolerance{o["periodTolerance"].tryGetFloat(RenderOptions{}.periodTolerance)}
+	, sampleTolerance{o["sampleTolerance"].tryGetFloat(RenderOptions{}.sampleTolerance)}
+	, numThreads{o["numThreads"].tryGetInteger(RenderOptions{}.numThreads)}{
+		if(!(periodTolerance >= 0.0f && periodTolerance <= maxPeriodTolerance)){
+			throw std::invalid_argument("RenderOptions: periodTolerance should be in [0, " + std::to_string(maxPeriodTolerance) + "]");
+		}
+		if(!(sampleTolerance >= 0.0f && sampleTolerance <= maxSampleTolerance)){
+			throw std::invalid_argument("RenderOptions: sampleTolerance should be in [0, " + std::to_string(maxSampleTolerance) + "]");
+		}
+		if(numThreads < 0){
+			throw std::invalid_argument("RenderOptions: numThreads should be >= 0");
+		}
+	}
+	JsonBox::Object RenderOptions::toJson() const noexcept{
+		JsonBox::Object o;
+		o["periodTolerance"] = JsonBox::Value(periodTolerance);
+		o["sampleTolerance"] = JsonBox::Value(sampleTolerance);
+		o["numThreads"] = JsonBox::Value(numThreads);
+		return o;
+	}
+	void setRenderOptions(const RenderOptions& options) noexcept{
+		std::lock_guard lock(optionsMutex());
+		currentOptions() = options;
+	}
+	RenderOptions getRenderOptions() noexcept{
+		std::lock_guard lock(optionsMutex());
+		return currentOptions();
+	}
+} // namespace fe
@@ -1,4 +1,6 @@
 #include <Stats.hpp>
+#include <CPPN.hpp>
+#include <JsonReader.hpp>
 #include <EvoAI/Utils/MathUtils.hpp>
 
 namespace fe{
@@ -9,6 +11,8 @@ namespace fe{
 	, strength{0.0}
 	, luck{0.0}{}
 	Stats::Stats(const std::string& genome, float humidity, int temperature, int altitude, int terrainType)
+	: Stats(readFlowerDNA(genome), humidity, temperature, altitude, terrainType){}
+	Stats::Stats(const DNA& dna, float humidity, int temperature, int altitude, int terrainType)
 	: sex{Sex::Both}
 	, health{100}
 	, stamina{100}
@@ -16,12 +20,6 @@ namespace fe{
 	, maxTemperature{100}
 	, toxicityRate{0.0}
 	, effects{}{
-		JsonBox::Value v1;
-		v1.loadFromString(genome);
-		if(v1["Flower"]["dna"].isNull()){
-			throw std::invalid_argument("error, invalid flower, could not parse data.");
-		}
-		fe::DNA dna(v1["Flower"]["dna"].getObject());
 		if(dna.size() < 2){
 			throw std::invalid_argument("invalid DNA, it should have 2 genomes");
 		}
@@ -49,7 +47,12 @@ namespace fe{
 		//   health, stamina, min temperature, max temperature, maturationPeriod, male, female, toxicityRate
 		//   maturationPeriod
 		//    how long it takes to bloom, it can be seconds, hours, days, weeks, etc.
-		auto nn = EvoAI::Genome::makePhenotype(dna[0]);
+		auto nn = getCPPN(dna[0]);
+		std::vector<double> out(nn->getNumOutputs());
+		auto forward = [&](double a, double b, double c, double d){
+			const double inputs[] = {a, b, c, d};
+			nn->forward(inputs, out.data());
+		};
 		auto normalizeValue = [](auto value){
 			return EvoAI::normalize(std::clamp(static_cast<double>(value), -10000.0, 10000.0), -1.0, 1.0, -10000.0, 10000.0);
 		};
@@ -58,8 +61,7 @@ namespace fe{
 		double altitudeNorm = normalizeValue(altitude);
 		double terrainTypeNorm = normalizeValue(terrainType);
 		// get initial values.
-		auto out = nn.forward({humidityNorm, temperatureNorm, altitudeNorm, terrainTypeNorm});
-		nn.reset();
+		forward(humidityNorm, temperatureNorm, altitudeNorm, terrainTypeNorm);
 		auto getSex = [](double male, double female){
 			if(male > 0.5 && female > 0.5){
 				return Stats::Sex::Both;
@@ -97,13 +99,7 @@ namespace fe{
 			&Effects::luck
 		};
 		for(auto i=0u;i<5;++i){
-			out = nn.forward({
-				static_cast<double>(humidityNorm), 
-				static_cast<double>(temperatureNorm), 
-				static_cast<double>(altitudeNorm), 
-				transforms[i](normalizeValue(effectID * i))
-			});
-			nn.reset();
+			forward(humidityNorm, temperatureNorm, altitudeNorm, transforms[i](normalizeValue(effectID * i)));
 			effects.*effectMembers[i] = std::clamp(calcEffect(out), -100.0, 100.0);
 		}
 	}
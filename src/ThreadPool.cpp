@@ -0,0 +1,141 @@
+#include <ThreadPool.hpp>
+
+#include <algorithm>
+
+#if !defined(FE_THREAD_POOL_SIZE)
+	#if defined(__EMSCRIPTEN__)
+		/// -sPTHREAD_POOL_SIZE
+		#define FE_THREAD_POOL_SIZE 4
+	#else
+		#define FE_THREAD_POOL_SIZE 64
+	#endif
+#endif
+
+namespace fe{
+	namespace{
+		/// set while the thread runs tasks, nested runs go serial.
+		thread_local bool isRunningTasks = false;
+	} // namespace
+	ThreadPool::ThreadPool(std::size_t numWorkers) noexcept
+	: m_queues()
+	, m_workers()
+	, m_runMutex()
+	, m_mutex()
+	, m_wake()
+	, m_done()
+	, m_job(nullptr)
+	, m_numActive(0)
+	, m_generation(0)
+	, m_remaining(0)
+	, m_stop(false){
+		for(auto i=0u;i<=numWorkers;++i){
+			m_queues.emplace_back(std::make_unique<Queue>());
+		}
+		for(auto i=1u;i<=numWorkers;++i){
+			m_workers.emplace_back(&ThreadPool::work, this, i);
+		}
+	}
+	ThreadPool::~ThreadPool(){
+		{
+			std::lock_guard lock(m_mutex);
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		for(auto& w:m_workers){
+			w.join();
+		}
+	}
+	std::size_t ThreadPool::getNumThreads() const noexcept{
+		return m_queues.size();
+	}
+	void ThreadPool::run(std::size_t numTasks, std::size_t maxThreads, const std::function<void(std::size_t)>& fn) noexcept{
+		const auto numThreads = std::min({maxThreads == 0 ? getNumThreads():maxThreads, getNumThreads(), numTasks});
+		std::unique_lock runLock(m_runMutex, std::defer_lock);
+		if(numThreads <= 1 || isRunningTasks || !runLock.try_lock()){
+			for(auto task=0u;task<numTasks;++task){
+				fn(task);
+			}
+			return;
+		}
+		{
+			std::lock_guard lock(m_mutex);
+			m_job = &fn;
+			m_numActive = numThreads;
+			m_remaining = numTasks;
+			for(auto i=0u;i<numThreads;++i){
+				std::lock_guard queueLock(m_queues[i]->mutex);
+				for(auto task=i*numTasks/numThreads;task<(i+1)*numTasks/numThreads;++task){
+					m_queues[i]->tasks.emplace_back(task);
+				}
+			}
+			++m_generation;
+		}
+		m_wake.notify_all();
+		runTasks(0);
+		std::unique_lock lock(m_mutex);
+		m_done.wait(lock, [this](){
+			return m_remaining == 0;
+		});
+		m_job = nullptr;
+	}
+	void ThreadPool::work(std::size_t thread) noexcept{
+		std::uint64_t generation = 0;
+		while(true){
+			{
+				std::unique_lock lock(m_mutex);
+				m_wake.wait(lock, [&](){
+					return m_stop || m_generation != generation;
+				});
+				if(m_stop){
+					return;
+				}
+				generation = m_generation;
+				if(thread >= m_numActive){
+					continue;
+				}
+			}
+			runTasks(thread);
+		}
+	}
+	void ThreadPool::runTasks(std::size_t thread) noexcept{
+		isRunningTasks = true;
+		std::size_t task;
+		while(pop(thread, task) || steal(thread, task)){
+			(*m_job)(task);
+			if(--m_remaining == 0){
+				std::lock_guard lock(m_mutex);
+				m_done.notify_all();
+			}
+		}
+		isRunningTasks = false;
+	}
+	bool ThreadPool::pop(std::size_t thread, std::size_t& task) noexcept{
+		auto& queue = *m_queues[thread];
+		std::lock_guard lock(queue.mutex);
+		if(queue.tasks.empty()){
+			return false;
+		}
+		task = queue.tasks.front();
+		queue.tasks.pop_front();
+		return true;
+	}
+	bool ThreadPool::steal(std::size_t thread, std::size_t& task) noexcept{
+		for(auto i=1u;i<m_queues.size();++i){
+			auto& queue = *m_queues[(thread + i) % m_queues.size()];
+			std::lock_guard lock(queue.mutex);
+			if(!queue.tasks.empty()){
+				task = queue.tasks.back();
+				queue.tasks.pop_back();
+				return true;
+			}
+		}
+		return false;
+	}
+	ThreadPool& getThreadPool() noexcept{
+		static ThreadPool pool([](){
+			const std::size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+			return std::min<std::size_t>(hardware - 1, FE_THREAD_POOL_SIZE);
+		}());
+		return pool;
+	}
+} // namespace fe
@@ -0,0 +1,110 @@
+#include <Trace.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace fe::trace{
+	namespace{
+		constexpr std::size_t defaultCapacity = 4096;
+		/**
+		 * @brief fixed size buffer, when full the oldest events are overwritten.
+		 */
+		struct RingBuffer{
+			std::mutex mutex;
+			std::vector<Event> events = std::vector<Event>(defaultCapacity);
+			std::size_t next{0};
+			std::size_t size{0};
+		};
+		RingBuffer& buffer() noexcept{
+			static RingBuffer rb;
+			return rb;
+		}
+		std::atomic<bool> enabled{false};
+		std::atomic<int> nextTid{0};
+		const auto epoch = std::chrono::steady_clock::now();
+
+		int threadID() noexcept{
+			thread_local int tid = nextTid.fetch_add(1);
+			return tid;
+		}
+		std::int64_t toMicroseconds(std::chrono::steady_clock::duration d) noexcept{
+			return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+		}
+	} // namespace
+	void setEnabled(bool enable) noexcept{
+		enabled.store(enable, std::memory_order_relaxed);
+	}
+	bool isEnabled() noexcept{
+		return enabled.load(std::memory_order_relaxed);
+	}
+	void setCapacity(std::size_t capacity) noexcept{
+		auto& rb = buffer();
+		std::lock_guard lock(rb.mutex);
+		rb.events.assign(std::max<std::size_t>(capacity, 1), Event{});
+		rb.next = 0;
+		rb.size = 0;
+	}
+	void record(const Event& e) noexcept{
+		auto& rb = buffer();
+		std::lock_guard lock(rb.mutex);
+		rb.events[rb.next] = e;
+		rb.next = (rb.next + 1) % rb.events.size();
+		rb.size = std::min(rb.size + 1, rb.events.size());
+	}
+	JsonBox::Value toJson() noexcept{
+		auto& rb = buffer();
+		std::lock_guard lock(rb.mutex);
+		JsonBox::Array traceEvents;
+		auto capacity = rb.events.size();
+		auto first = (rb.next + capacity - rb.size) % capacity;
+		for(auto i=0u;i<rb.size;++i){
+			const auto& e = rb.events[(first + i) % capacity];
+			JsonBox::Object o;
+			o["name"] = JsonBox::Value(e.name);
+			o["cat"] = JsonBox::Value("fe");
+			o["ph"] = JsonBox::Value("X");
+			o["ts"] = JsonBox::Value(static_cast<double>(e.start));
+			o["dur"] = JsonBox::Value(static_cast<double>(e.duration));
+			o["pid"] = JsonBox::Value(1);
+			o["tid"] = JsonBox::Value(e.tid);
+			if(e.argName){
+				JsonBox::Object args;
+				args[e.argName] = JsonBox::Value(static_cast<double>(e.argValue));
+				o["args"] = JsonBox::Value(args);
+			}
+			traceEvents.emplace_back(o);
+		}
+		JsonBox::Object root;
+		root["traceEvents"] = JsonBox::Value(traceEvents);
+		root["displayTimeUnit"] = JsonBox::Value("ms");
+		return JsonBox::Value(root);
+	}
+	void clear() noexcept{
+		auto& rb = buffer();
+		std::lock_guard lock(rb.mutex);
+		rb.next = 0;
+		rb.size = 0;
+	}
+	Span::Span(const char* name, const char* argName, std::int64_t argValue) noexcept
+	: m_name(name)
+	, m_argName(argName)
+	, m_argValue(argValue)
+	, m_active(isEnabled())
+	, m_start(m_active ? std::chrono::steady_clock::now():std::chrono::steady_clock::time_point{}){}
+	Span::~Span() noexcept{
+		if(!m_active){
+			return;
+		}
+		auto end = std::chrono::steady_clock::now();
+		Event e;
+		e.name = m_name;
+		e.start = toMicroseconds(m_start - epoch);
+		e.duration = toMicroseconds(end - m_start);
+		e.tid = threadID();
+		e.argName = m_argName;
+		e.argValue = m_argValue;
+		record(e);
+	}
+} // namespace fe::trace
@@ -0,0 +1,41 @@
+#include <Platform.hpp>
+
+#include <algorithm>
+#include <atomic>
+#if defined(__GLIBC__)
+	#include <malloc.h>
+#endif
+
+namespace{
+	/// in-memory replacement for the html canvas.
+	thread_local fe::Image canvas;
+} // namespace
+
+void copyToCanvas(std::uint8_t* ptr, int w, int h){
+	canvas.mWidth = static_cast<std::size_t>(std::max(w, 0));
+	canvas.mHeight = static_cast<std::size_t>(std::max(h, 0));
+	canvas.imageData.assign(ptr, ptr + canvas.mWidth * canvas.mHeight * 4);
+}
+
+namespace fe::platform{
+	const fe::Image& getCanvas() noexcept{
+		return canvas;
+	}
+	HeapStats getHeapStats() noexcept{
+		HeapStats stats;
+	#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+		// glibc doesn't keep the high-water mark, it's the largest footprint seen by the calls
+		static std::atomic<std::size_t> sampledFootprint{0};
+		auto info = mallinfo2();
+		stats.footprint = info.arena + info.hblkhd;
+		stats.inUse = info.uordblks + info.hblkhd;
+		auto seen = sampledFootprint.load();
+		while(seen < stats.footprint && !sampledFootprint.compare_exchange_weak(seen, stats.footprint)){}
+		stats.maxFootprint = std::max(seen, stats.footprint);
+	#endif
+		return stats;
+	}
+	std::size_t getHeapMax() noexcept{
+		return 0;
+	}
+} // namespace fe::platform
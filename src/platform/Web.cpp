@@ -0,0 +1,32 @@
+#include <Platform.hpp>
+
+#include <emscripten.h>
+#include <emscripten/heap.h>
+#include <malloc.h>
+
+void copyToCanvas(std::uint8_t* ptr, int w, int h){
+	EM_ASM_({
+                let canvas = typeof importScripts === 'function' ? self.canvas:document.getElementById("canvas");
+                // the module is built with -pthread so the wasm memory is a SharedArrayBuffer that ImageData
+                // can't view, the pixels are copied once and putImageData writes them without reading the canvas back
+                let pixels = new Uint8ClampedArray(Module.HEAPU8.subarray($0, $0 + $1 * $2 * 4));
+                let context = canvas.getContext('2d');
+                context.putImageData(new ImageData(pixels, $1, $2), 0, 0);
+    }, ptr, w, h);
+}
+
+namespace fe::platform{
+	HeapStats getHeapStats() noexcept{
+		auto info = mallinfo();
+		HeapStats stats;
+		stats.heapSize = emscripten_get_heap_size();
+		stats.footprint = static_cast<std::size_t>(info.arena);
+		// dlmalloc keeps the max footprint in usmblks
+		stats.maxFootprint = static_cast<std::size_t>(info.usmblks);
+		stats.inUse = static_cast<std::size_t>(info.uordblks);
+		return stats;
+	}
+	std::size_t getHeapMax() noexcept{
+		return emscripten_get_heap_max();
+	}
+} // namespace fe::platform
@@ -0,0 +1,498 @@
+#include <CPPN.hpp>
+#include <Petals.hpp>
+#include <RenderOptions.hpp>
+#include <ThreadPool.hpp>
+#include <DNA.hpp>
+#include <Image.hpp>
+#include <3D.hpp>
+
+#include <EvoAI.hpp>
+#include <JsonBox.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace{
+	/**
+	 * @brief benchmark options.
+	 */
+	struct Options{
+		int iterations{5};
+		std::string filter;
+		std::vector<int> radii{32, 64, 128, 256};
+		int minLayers{1};
+		int maxLayers{8};
+		float P{6.0f};
+		float bias{1.0f};
+		bool check{false};
+	};
+	/**
+	 * @brief fixed genome, it will always be the same for a given seed and number of mutations.
+	 */
+	struct BenchGenome{
+		std::string name;
+		fe::DNA dna;
+	};
+	/**
+	 * @brief timings in microseconds.
+	 */
+	struct Timing{
+		double min{0.0};
+		double median{0.0};
+		double mean{0.0};
+		double max{0.0};
+	};
+
+	constexpr unsigned int benchSeed = 42u;
+
+	BenchGenome makeGenome(const std::string& name, unsigned int seed, int numMutations){
+		EvoAI::randomGen().setSeed(seed);
+		fe::DNA dna;
+		dna.add(EvoAI::Genome(4,14,false,true));
+		dna.add(EvoAI::Genome(4,4,false,true));
+		for(auto i=0;i<numMutations;++i){
+			dna.mutate(fe::MutationRates());
+		}
+		return {name, std::move(dna)};
+	}
+	/**
+	 * @brief runs setup (not timed) and fn (timed) once as warm-up and then iterations times.
+	 *        the random generator is re-seeded before each run so every run does the same work.
+	 */
+	Timing measure(int iterations, const std::function<void()>& setup, const std::function<void()>& fn){
+		std::vector<double> samples;
+		samples.reserve(iterations);
+		for(auto i=-1;i<iterations;++i){
+			setup();
+			EvoAI::randomGen().setSeed(benchSeed);
+			auto start = std::chrono::steady_clock::now();
+			fn();
+			auto end = std::chrono::steady_clock::now();
+			if(i >= 0){
+				samples.emplace_back(std::chrono::duration<double, std::micro>(end - start).count());
+			}
+		}
+		Timing t;
+		if(samples.empty()){
+			return t;
+		}
+		std::sort(std::begin(samples), std::end(samples));
+		t.min = samples.front();
+		t.max = samples.back();
+		t.median = samples[samples.size() / 2];
+		for(auto s:samples){
+			t.mean += s;
+		}
+		t.mean /= static_cast<double>(samples.size());
+		return t;
+	}
+
+	class Report final{
+		public:
+			explicit Report(const Options& opts)
+			: m_opts(opts)
+			, m_results(){}
+			bool enabled(const std::string& stage) const noexcept{
+				return m_opts.filter.empty() || stage.find(m_opts.filter) != std::string::npos;
+			}
+			void add(const std::string& stage, const BenchGenome& g, int radius, int numLayers, const Timing& t, JsonBox::Object extra = {}){
+				extra["stage"] = JsonBox::Value(stage);
+				extra["genome"] = JsonBox::Value(g.name);
+				extra["radius"] = JsonBox::Value(radius);
+				extra["numLayers"] = JsonBox::Value(numLayers);
+				extra["min_us"] = JsonBox::Value(t.min);
+				extra["median_us"] = JsonBox::Value(t.median);
+				extra["mean_us"] = JsonBox::Value(t.mean);
+				extra["max_us"] = JsonBox::Value(t.max);
+				m_results.emplace_back(extra);
+				std::cerr << stage << " " << g.name << " r=" << radius << " l=" << numLayers << " median=" << t.median << "us\n";
+			}
+			void write(std::ostream& os) const{
+				JsonBox::Object o;
+				o["benchmark"] = JsonBox::Value("FlowerEvolver");
+				o["seed"] = JsonBox::Value(static_cast<int>(benchSeed));
+				o["iterations"] = JsonBox::Value(m_opts.iterations);
+				o["P"] = JsonBox::Value(m_opts.P);
+				o["bias"] = JsonBox::Value(m_opts.bias);
+				o["results"] = JsonBox::Value(m_results);
+				JsonBox::Value(o).writeToStream(os, true, false);
+				os << "\n";
+			}
+		private:
+			const Options& m_opts;
+			JsonBox::Array m_results;
+	};
+
+	fe::Petals makeLayerPetals(int radius, int numLayers, const Options& opts){
+		auto petals = fe::Petals();
+		petals.radius = radius;
+		petals.numLayers = numLayers;
+		petals.P = opts.P;
+		petals.bias = opts.bias;
+		petals.image.create(radius*2, radius*2, sf::Color::Transparent);
+		return petals;
+	}
+
+	/**
+	 * @brief draws the petal layers like fe::draw does with drawLayerFn.
+	 */
+	template<typename DrawLayerFn>
+	void drawAllLayers(fe::Petals& petals, const fe::CPPN& nn, DrawLayerFn&& drawLayerFn){
+		auto currentRadius = petals.radius;
+		for(auto layer=petals.numLayers;layer>=0;--layer){
+			drawLayerFn(petals, nn, currentRadius, layer);
+			currentRadius /= 2;
+		}
+	}
+
+	void benchRaster(Report& report, BenchGenome& g, int radius, int numLayers, const Options& opts){
+		fe::CPPN nn(g.dna[1]);
+		fe::Petals rayMarch(radius, numLayers, opts.P, opts.bias);
+		fe::Petals scanline(radius, numLayers, opts.P, opts.bias);
+		auto tRayMarch = measure(opts.iterations, [&](){ rayMarch.image.create(radius*2, radius*2, sf::Color::Transparent); },
+								[&](){ drawAllLayers(rayMarch, nn, fe::priv::drawPetalsRayMarch); });
+		auto tScanline = measure(opts.iterations, [&](){ scanline.image.create(radius*2, radius*2, sf::Color::Transparent); },
+								[&](){ drawAllLayers(scanline, nn, fe::priv::drawPetals); });
+		auto diff = fe::priv::compareRasters(rayMarch.image, scanline.image);
+		JsonBox::Object extra;
+		extra["coverage"] = JsonBox::Value(diff.coverage);
+		extra["meanColorError"] = JsonBox::Value(diff.meanColorError);
+		extra["coveredPixels"] = JsonBox::Value(static_cast<int>(diff.coveredPixels));
+		extra["withinTolerance"] = JsonBox::Value(diff.isWithin(fe::priv::rasterTolerance));
+		extra["speedup"] = JsonBox::Value(tScanline.median > 0.0 ? tRayMarch.median / tScanline.median:0.0);
+		report.add("drawPetals.rayMarch", g, radius, numLayers, tRayMarch);
+		report.add("drawPetals.scanline", g, radius, numLayers, tScanline, extra);
+		if(report.enabled("drawPetals.period")){
+			// sharing the evaluations between petals within a tolerance
+			const auto options = fe::getRenderOptions();
+			auto periodOptions = options;
+			periodOptions.periodTolerance = options.periodTolerance > 0.0f ? options.periodTolerance:1e-5f;
+			fe::setRenderOptions(periodOptions);
+			fe::Petals period(radius, numLayers, opts.P, opts.bias);
+			auto tPeriod = measure(opts.iterations, [&](){ period.image.create(radius*2, radius*2, sf::Color::Transparent); },
+								[&](){ drawAllLayers(period, nn, fe::priv::drawPetals); });
+			fe::setRenderOptions(options);
+			auto periodDiff = fe::priv::compareRasters(scanline.image, period.image);
+			JsonBox::Object periodExtra;
+			periodExtra["periodTolerance"] = JsonBox::Value(periodOptions.periodTolerance);
+			periodExtra["coverage"] = JsonBox::Value(periodDiff.coverage);
+			periodExtra["meanColorError"] = JsonBox::Value(periodDiff.meanColorError);
+			periodExtra["speedup"] = JsonBox::Value(tPeriod.median > 0.0 ? tScanline.median / tPeriod.median:0.0);
+			report.add("drawPetals.period", g, radius, numLayers, tPeriod, periodExtra);
+		}
+		if(report.enabled("drawPetals.adaptive")){
+			// the radius input of inner layers sampled coarse to fine
+			const auto options = fe::getRenderOptions();
+			auto adaptiveOptions = options;
+			adaptiveOptions.sampleTolerance = options.sampleTolerance > 0.0f ? options.sampleTolerance:0.2f;
+			fe::setRenderOptions(adaptiveOptions);
+			fe::Petals adaptive(radius, numLayers, opts.P, opts.bias);
+			auto tAdaptive = measure(opts.iterations, [&](){ adaptive.image.create(radius*2, radius*2, sf::Color::Transparent); },
+									[&](){ drawAllLayers(adaptive, nn, fe::priv::drawPetals); });
+			fe::setRenderOptions(options);
+			auto adaptiveDiff = fe::priv::compareRasters(scanline.image, adaptive.image);
+			JsonBox::Object adaptiveExtra;
+			adaptiveExtra["sampleTolerance"] = JsonBox::Value(adaptiveOptions.sampleTolerance);
+			adaptiveExtra["coverage"] = JsonBox::Value(adaptiveDiff.coverage);
+			adaptiveExtra["meanColorError"] = JsonBox::Value(adaptiveDiff.meanColorError);
+			adaptiveExtra["speedup"] = JsonBox::Value(tAdaptive.median > 0.0 ? tScanline.median / tAdaptive.median:0.0);
+			report.add("drawPetals.adaptive", g, radius, numLayers, tAdaptive, adaptiveExtra);
+		}
+		if(report.enabled("drawPetals.frontToBack")){
+			fe::Petals frontToBack(radius, numLayers, opts.P, opts.bias);
+			auto tFrontToBack = measure(opts.iterations, [&](){ frontToBack.image.create(radius*2, radius*2, sf::Color::Transparent); },
+										[&](){ fe::priv::drawAllPetals(frontToBack, nn); });
+			JsonBox::Object frontToBackExtra;
+			frontToBackExtra["identical"] = JsonBox::Value(frontToBack.image.imageData == scanline.image.imageData);
+			frontToBackExtra["speedup"] = JsonBox::Value(tFrontToBack.median > 0.0 ? tScanline.median / tFrontToBack.median:0.0);
+			report.add("drawPetals.frontToBack", g, radius, numLayers, tFrontToBack, frontToBackExtra);
+		}
+		if(report.enabled("drawPetals.singleThread")){
+			// scanline uses the thread pool (numThreads), this renders in the calling thread
+			const auto options = fe::getRenderOptions();
+			auto singleOptions = options;
+			singleOptions.numThreads = 1;
+			fe::setRenderOptions(singleOptions);
+			fe::Petals single(radius, numLayers, opts.P, opts.bias);
+			auto tSingle = measure(opts.iterations, [&](){ single.image.create(radius*2, radius*2, sf::Color::Transparent); },
+								[&](){ drawAllLayers(single, nn, fe::priv::drawPetals); });
+			fe::setRenderOptions(options);
+			JsonBox::Object singleExtra;
+			singleExtra["threads"] = JsonBox::Value(static_cast<int>(options.numThreads > 0 ? options.numThreads:fe::getThreadPool().getNumThreads()));
+			singleExtra["identical"] = JsonBox::Value(single.image.imageData == scanline.image.imageData);
+			singleExtra["speedup"] = JsonBox::Value(tScanline.median > 0.0 ? tSingle.median / tScanline.median:0.0);
+			report.add("drawPetals.singleThread", g, radius, numLayers, tSingle, singleExtra);
+		}
+	}
+
+	/**
+	 * @brief compares drawPetals against drawPetalsRayMarch for every genome, radius and number of layers.
+	 * @return bool true if all of them are within fe::priv::rasterTolerance.
+	 */
+	bool checkRaster(std::vector<BenchGenome>& genomes, const Options& opts){
+		bool passed = true;
+		for(auto& g:genomes){
+			fe::CPPN nn(g.dna[1]);
+			for(auto radius:opts.radii){
+				radius = std::clamp(radius, 4, 256);
+				auto maxLayers = std::min(opts.maxLayers, fe::getTimesDivisibleBy(radius, 2));
+				for(auto numLayers = opts.minLayers;numLayers<=maxLayers;++numLayers){
+					fe::Petals rayMarch(radius, numLayers, opts.P, opts.bias);
+					fe::Petals scanline(radius, numLayers, opts.P, opts.bias);
+					drawAllLayers(rayMarch, nn, fe::priv::drawPetalsRayMarch);
+					drawAllLayers(scanline, nn, fe::priv::drawPetals);
+					auto diff = fe::priv::compareRasters(rayMarch.image, scanline.image);
+					if(!diff.isWithin(fe::priv::rasterTolerance)){
+						std::cerr << "drawPetals " << g.name << " r=" << radius << " l=" << numLayers
+								  << " coverage=" << diff.coverage << " meanColorError=" << diff.meanColorError << "\n";
+						passed = false;
+					}
+				}
+			}
+		}
+		return passed;
+	}
+
+	void benchCPPN(Report& report, BenchGenome& g, int radius, int numLayers, const Options& opts){
+		fe::CPPN nn(g.dna[1]);
+		// one input per pixel of the petals image
+		const auto count = static_cast<std::size_t>(radius * radius * 4);
+		std::vector<double> inputs[4];
+		std::vector<double> outputs[4];
+		for(auto i=0u;i<count;++i){
+			inputs[0].emplace_back(i % (radius + 1));
+			inputs[1].emplace_back(std::sin(opts.P * i * 0.001));
+			inputs[2].emplace_back(numLayers);
+			inputs[3].emplace_back(opts.bias);
+		}
+		for(auto& out:outputs){
+			out.resize(count);
+		}
+		JsonBox::Object extra;
+		extra["compiled"] = JsonBox::Value(nn.isCompiled());
+		extra["evaluations"] = JsonBox::Value(static_cast<int>(count));
+		if(report.enabled("cppn.forward")){
+			auto t = measure(opts.iterations, [](){}, [&](){
+				double in[4];
+				double out[4];
+				for(auto i=0u;i<count;++i){
+					for(auto k=0u;k<4;++k){
+						in[k] = inputs[k][i];
+					}
+					nn.forward(in, out);
+					for(auto k=0u;k<4;++k){
+						outputs[k][i] = out[k];
+					}
+				}
+			});
+			report.add("cppn.forward", g, radius, numLayers, t, extra);
+		}
+		if(report.enabled("cppn.forwardBatch")){
+			const double* in[] = {inputs[0].data(), inputs[1].data(), inputs[2].data(), inputs[3].data()};
+			double* out[] = {outputs[0].data(), outputs[1].data(), outputs[2].data(), outputs[3].data()};
+			auto t = measure(opts.iterations, [](){}, [&](){ nn.forwardBatch(in, out, count); });
+			report.add("cppn.forwardBatch", g, radius, numLayers, t, extra);
+		}
+	}
+
+	void bench2D(Report& report, BenchGenome& g, int radius, int numLayers, const Options& opts){
+		if(report.enabled("cppn.forward") || report.enabled("cppn.forwardBatch")){
+			benchCPPN(report, g, radius, numLayers, opts);
+		}
+		if(report.enabled("drawPetals.rayMarch") || report.enabled("drawPetals.scanline") || report.enabled("drawPetals.period")
+			|| report.enabled("drawPetals.adaptive") || report.enabled("drawPetals.frontToBack")
+			|| report.enabled("drawPetals.singleThread")){
+			benchRaster(report, g, radius, numLayers, opts);
+		}
+		if(report.enabled("drawLayer")){
+			auto petals = makeLayerPetals(radius, numLayers, opts);
+			auto t = measure(opts.iterations, [&](){ petals.image.create(radius*2, radius*2, sf::Color::Transparent); },
+							[&](){ fe::drawLayer(petals, g.dna[1], numLayers, false); });
+			report.add("drawLayer", g, radius, numLayers, t);
+		}
+		const std::pair<fe::Petals::Type, const char*> types[] = {
+			{fe::Petals::Type::Trunk, "draw.Trunk"},
+			{fe::Petals::Type::Petals, "draw.Petals"},
+			{fe::Petals::Type::TrunkAndPetals, "draw.TrunkAndPetals"}
+		};
+		for(const auto& [type, stage]:types){
+			if(!report.enabled(stage)){
+				continue;
+			}
+			fe::Petals petals(radius, numLayers, opts.P, opts.bias);
+			auto t = measure(opts.iterations, [&](){ petals.image.create(radius*2, radius*3, sf::Color::Transparent); },
+							[&](){ fe::draw(type, petals, g.dna[1]); });
+			report.add(stage, g, radius, numLayers, t);
+		}
+		if(report.enabled("encodeImageToPngInMemory") || report.enabled("encodeToBase64")){
+			fe::Petals petals(radius, numLayers, opts.P, opts.bias);
+			EvoAI::randomGen().setSeed(benchSeed);
+			fe::draw(fe::Petals::Type::TrunkAndPetals, petals, g.dna[1]);
+			std::vector<std::uint8_t> png;
+			auto tPng = measure(opts.iterations, [](){}, [&](){ png = fe::encodeImageToPngInMemory(petals.image); });
+			if(report.enabled("encodeImageToPngInMemory")){
+				JsonBox::Object extra;
+				extra["bytes"] = JsonBox::Value(static_cast<int>(png.size()));
+				report.add("encodeImageToPngInMemory", g, radius, numLayers, tPng, extra);
+			}
+			if(report.enabled("encodeToBase64")){
+				std::string b64;
+				auto tB64 = measure(opts.iterations, [](){}, [&](){ b64 = fe::encodeToBase64(png); });
+				JsonBox::Object extra;
+				extra["bytes"] = JsonBox::Value(static_cast<int>(b64.size()));
+				report.add("encodeToBase64", g, radius, numLayers, tB64, extra);
+			}
+		}
+	}
+
+	void bench3D(Report& report, BenchGenome& g, int radius, int numLayers, const Options& opts){
+		const fe::FlowerParameters params{};
+		auto petals = makeLayerPetals(radius, numLayers, opts);
+		EvoAI::randomGen().setSeed(benchSeed);
+		fe::drawLayer(petals, g.dna[1], numLayers, false);
+		const auto& image = petals.image;
+		auto width = static_cast<int>(image.mWidth);
+		auto height = static_cast<int>(image.mHeight);
+		std::vector<fe::Vec2i> contour;
+		if(report.enabled("findContourMoore")){
+			auto t = measure(opts.iterations, [](){},
+							[&](){ fe::findContourMoore(image.imageData, width, height, params.alphaThreshold, contour); });
+			JsonBox::Object extra;
+			extra["points"] = JsonBox::Value(static_cast<int>(contour.size()));
+			report.add("findContourMoore", g, radius, numLayers, t, extra);
+		}else{
+			fe::findContourMoore(image.imageData, width, height, params.alphaThreshold, contour);
+		}
+		std::vector<fe::Vec2i> simplified;
+		if(report.enabled("simplifyContour")){
+			auto t = measure(opts.iterations, [](){},
+							[&](){ fe::simplifyContour(contour, params.contourSimplificationTolerance, simplified); });
+			JsonBox::Object extra;
+			extra["points"] = JsonBox::Value(static_cast<int>(simplified.size()));
+			report.add("simplifyContour", g, radius, numLayers, t, extra);
+		}else{
+			fe::simplifyContour(contour, params.contourSimplificationTolerance, simplified);
+		}
+		if(report.enabled("generateNormalFromPetal")){
+			auto t = measure(opts.iterations, [](){},
+							[&](){ fe::priv::generateNormalFromPetal(image, fe::priv::NoiseOptions{}); });
+			report.add("generateNormalFromPetal", g, radius, numLayers, t);
+		}
+		if(simplified.size() < 3){
+			return;
+		}
+		if(report.enabled("generatePetalLayer")){
+			fe::gltf::Scene scene("bench");
+			auto t = measure(opts.iterations, [&](){ scene = fe::gltf::Scene("bench"); },
+							[&](){ fe::generatePetalLayer(scene, simplified, image, numLayers, {0.0f, 0.0f, 0.0f}, params); });
+			report.add("generatePetalLayer", g, radius, numLayers, t);
+		}
+		if(report.enabled("toJson")){
+			fe::gltf::Scene scene("bench");
+			EvoAI::randomGen().setSeed(benchSeed);
+			fe::generatePetalLayer(scene, simplified, image, numLayers, {0.0f, 0.0f, 0.0f}, params);
+			JsonBox::Value json;
+			auto tJson = measure(opts.iterations, [](){}, [&](){ json = fe::gltf::toJson(scene, params); });
+			report.add("toJson", g, radius, numLayers, tJson);
+			std::string str;
+			auto tStr = measure(opts.iterations, [](){}, [&](){ str = fe::gltf::toJsonStr(json); });
+			JsonBox::Object extra;
+			extra["bytes"] = JsonBox::Value(static_cast<int>(str.size()));
+			report.add("toJsonStr", g, radius, numLayers, tStr, extra);
+		}
+	}
+
+	void printUsage(const char* name) noexcept{
+		std::cout << "usage: " << name << " [options]\n\n"
+				  << "prints the timings as json to stdout, progress goes to stderr.\n\n"
+				  << "options:\n"
+				  << "  -i <int>             iterations per stage (default: 5)\n"
+				  << "  -f <string>          only run stages that contain <string>\n"
+				  << "  -r <int,int,...>     radii (default: 32,64,128,256)\n"
+				  << "  -l <min,max>         number of layers range (default: 1,8)\n"
+				  << "  --check              fails if drawPetals is not within rasterTolerance of the ray marcher\n"
+				  << "  -h, --help           shows this help\n";
+	}
+
+	std::vector<int> parseList(const std::string& str){
+		std::vector<int> values;
+		std::size_t start = 0;
+		while(start <= str.size()){
+			auto end = str.find(',', start);
+			if(end == std::string::npos){
+				end = str.size();
+			}
+			values.emplace_back(std::stoi(str.substr(start, end - start)));
+			start = end + 1;
+		}
+		return values;
+	}
+} // namespace
+
+int main(int argc, char** argv){
+	Options opts;
+	try{
+		for(auto i=1;i<argc;++i){
+			std::string arg = argv[i];
+			if((arg == "-h" || arg == "--help")){
+				printUsage(argv[0]);
+				return EXIT_SUCCESS;
+			}
+			if(arg == "--check"){
+				opts.check = true;
+				continue;
+			}
+			if(i + 1 >= argc){
+				throw std::invalid_argument("unknown argument or missing value " + arg);
+			}
+			std::string value = argv[++i];
+			if(arg == "-i"){
+				opts.iterations = std::max(std::stoi(value), 1);
+			}else if(arg == "-f"){
+				opts.filter = value;
+			}else if(arg == "-r"){
+				opts.radii = parseList(value);
+			}else if(arg == "-l"){
+				auto range = parseList(value);
+				opts.minLayers = range.front();
+				opts.maxLayers = range.back();
+			}else{
+				throw std::invalid_argument("unknown argument " + arg);
+			}
+		}
+	}catch(const std::exception& e){
+		std::cerr << "error: " << e.what() << "\n";
+		printUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	std::vector<BenchGenome> genomes;
+	genomes.emplace_back(makeGenome("base", 1u, 0));
+	genomes.emplace_back(makeGenome("mutated", 2u, 16));
+	if(opts.check){
+		if(!checkRaster(genomes, opts)){
+			return EXIT_FAILURE;
+		}
+		std::cerr << "drawPetals is within rasterTolerance of the ray marcher\n";
+		return EXIT_SUCCESS;
+	}
+	Report report(opts);
+	for(auto& g:genomes){
+		for(auto radius:opts.radii){
+			radius = std::clamp(radius, 4, 256);
+			auto maxLayers = std::min(opts.maxLayers, fe::getTimesDivisibleBy(radius, 2));
+			for(auto numLayers = opts.minLayers;numLayers<=maxLayers;++numLayers){
+				bench2D(report, g, radius, numLayers, opts);
+				bench3D(report, g, radius, numLayers, opts);
+			}
+		}
+	}
+	report.write(std::cout);
+	return EXIT_SUCCESS;
+}
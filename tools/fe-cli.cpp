@@ -0,0 +1,250 @@
+#include <FlowerEvolver.hpp>
+#include <Platform.hpp>
+#include <Image.hpp>
+#include <Binary.hpp>
+#include <JsonReader.hpp>
+
+#include <JsonBox.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace{
+	/**
+	 * @brief command line options, flower params default to the ones in the genome.
+	 */
+	struct Options{
+		std::string command;
+		std::string input;
+		std::string output{"flower"};
+		std::string flowerId{"flower"};
+		std::string flowerParams;
+		int radius{-1};
+		int numLayers{-1};
+		float P{-1.0f};
+		float bias{-1.0f};
+		int layer{0};
+		float humidity{0.5f};
+		int temperature{25};
+		int altitude{0};
+		int terrainType{0};
+		bool profile{false};
+		std::string traceFile;
+		/// empty uses a seed from the clock
+		std::string seed;
+		/// png or qoi
+		std::string format{"png"};
+		int effort{4};
+	};
+
+	void printUsage(const char* name) noexcept{
+		std::cout << "usage: " << name << " <command> [genome.json] [options]\n\n"
+				  << "commands:\n"
+				  << "  make                 makes a new flower, writes <out>.json and <out>.png|qoi\n"
+				  << "  draw   <genome>      draws the flower, writes <out>.png|qoi\n"
+				  << "  petals <genome>      draws only the petals, writes <out>.png|qoi\n"
+				  << "  layer  <genome>      draws a single petal layer, writes <out>.png|qoi\n"
+				  << "  3d     <genome>      makes a 3D flower, writes <out>.gltf\n"
+				  << "  stats  <genome>      prints the flower stats as json\n"
+				  << "  convert <genome>     converts json to binary, writes <out>.feb, or binary to json, writes <out>.json\n\n"
+				  << "genomes can be json or binary (.feb) files.\n\n"
+				  << "options:\n"
+				  << "  -r <int>             radius [4, 256]\n"
+				  << "  -l <int>             number of layers\n"
+				  << "  -p <float>           P\n"
+				  << "  -b <float>           bias\n"
+				  << "  -o <path>            output path without extension (default: flower)\n"
+				  << "  --layer <int>        layer to draw for the layer command\n"
+				  << "  --id <string>        flower id for the 3d command\n"
+				  << "  --params <file>      FlowerParameters json file for the 3d command\n"
+				  << "  --env <h,t,a,tt>     humidity, temperature, altitude, terrainType for stats\n"
+				  << "  --format png|qoi     image format for the drawn flowers (default png)\n"
+				  << "  --effort <0-9>       png compression level, higher is smaller but slower (default 4)\n"
+				  << "  --profile            prints the profiling counters to stderr (build with FE_PROFILE)\n"
+				  << "  --trace <file>       writes a chrome trace (Perfetto / chrome://tracing) of the command\n"
+				  << "  --seed <int>         seed for the random numbers, the same seed gives the same output\n"
+				  << "  -h, --help           shows this help\n";
+	}
+
+	std::string readFile(const std::string& filename){
+		std::ifstream file(filename, std::ios::binary);
+		if(!file){
+			throw std::runtime_error("could not open " + filename);
+		}
+		std::stringstream ss;
+		ss << file.rdbuf();
+		return ss.str();
+	}
+
+	template<typename Data>
+	void writeFile(const std::string& filename, const Data& data){
+		std::ofstream file(filename, std::ios::binary);
+		if(!file){
+			throw std::runtime_error("could not write " + filename);
+		}
+		file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+	}
+	/**
+	 * @brief writes the last image given to copyToCanvas as <output>.png or <output>.qoi.
+	 */
+	void writeCanvas(const Options& opts){
+		const auto filename = opts.output + "." + opts.format;
+		if(opts.format == "qoi"){
+			writeFile(filename, fe::encodeImageToQoiInMemory(fe::platform::getCanvas()));
+		}else{
+			fe::PngOptions png;
+			png.level = opts.effort;
+			writeFile(filename, fe::encodeImageToPngInMemory(fe::platform::getCanvas(), png));
+		}
+		std::cout << "wrote " << filename << "\n";
+	}
+	/**
+	 * @brief fills the flower params that were not given with the ones in the genome.
+	 */
+	void fillParamsFromGenome(Options& opts, const std::string& genome){
+		auto petals = fe::readFlowerPetals(genome);
+		if(opts.radius < 0){
+			opts.radius = petals["radius"].tryGetInteger(64);
+		}
+		if(opts.numLayers < 0){
+			opts.numLayers = petals["numLayers"].tryGetInteger(3);
+		}
+		if(opts.P < 0.0f){
+			opts.P = petals["P"].tryGetFloat(6.0f);
+		}
+		if(opts.bias < 0.0f){
+			opts.bias = petals["bias"].tryGetFloat(1.0f);
+		}
+	}
+
+	Options parseArgs(int argc, char** argv){
+		Options opts;
+		auto next = [&](int& i) -> std::string{
+			if(i + 1 >= argc){
+				throw std::invalid_argument(std::string("missing value for ") + argv[i]);
+			}
+			return argv[++i];
+		};
+		for(auto i=1;i<argc;++i){
+			std::string arg = argv[i];
+			if(arg == "-r"){
+				opts.radius = std::stoi(next(i));
+			}else if(arg == "-l"){
+				opts.numLayers = std::stoi(next(i));
+			}else if(arg == "-p"){
+				opts.P = std::stof(next(i));
+			}else if(arg == "-b"){
+				opts.bias = std::stof(next(i));
+			}else if(arg == "-o"){
+				opts.output = next(i);
+			}else if(arg == "--layer"){
+				opts.layer = std::stoi(next(i));
+			}else if(arg == "--id"){
+				opts.flowerId = next(i);
+			}else if(arg == "--params"){
+				opts.flowerParams = readFile(next(i));
+			}else if(arg == "--env"){
+				char sep;
+				std::stringstream ss(next(i));
+				ss >> opts.humidity >> sep >> opts.temperature >> sep >> opts.altitude >> sep >> opts.terrainType;
+			}else if(arg == "--format"){
+				opts.format = next(i);
+				if(opts.format != "png" && opts.format != "qoi"){
+					throw std::invalid_argument("unknown format " + opts.format + ", it should be png or qoi");
+				}
+			}else if(arg == "--effort"){
+				opts.effort = std::stoi(next(i));
+			}else if(arg == "--profile"){
+				opts.profile = true;
+			}else if(arg == "--trace"){
+				opts.traceFile = next(i);
+			}else if(arg == "--seed"){
+				opts.seed = next(i);
+			}else if(arg == "-h" || arg == "--help"){
+				opts.command = "help";
+			}else if(opts.command.empty()){
+				opts.command = arg;
+			}else if(opts.input.empty()){
+				opts.input = arg;
+			}else{
+				throw std::invalid_argument("unknown argument " + arg);
+			}
+		}
+		return opts;
+	}
+} // namespace
+
+int main(int argc, char** argv){
+	try{
+		auto opts = parseArgs(argc, argv);
+		if(opts.command.empty() || opts.command == "help"){
+			printUsage(argv[0]);
+			return opts.command.empty() ? EXIT_FAILURE:EXIT_SUCCESS;
+		}
+		setTraceEnabled(!opts.traceFile.empty());
+		if(!opts.seed.empty()){
+			setSeed(static_cast<double>(std::stoull(opts.seed)));
+		}
+		std::string genome = "{}";
+		if(opts.command != "make"){
+			if(opts.input.empty()){
+				throw std::invalid_argument(opts.command + " needs a genome file");
+			}
+			genome = readFile(opts.input);
+		}
+		const bool isBinary = fe::binary::isBinary(reinterpret_cast<const std::uint8_t*>(genome.data()), genome.size());
+		if(isBinary){
+			genome = binaryToFlower(genome);
+		}
+		fillParamsFromGenome(opts, genome);
+		if(opts.command == "make"){
+			genome = makeFlower(opts.radius, opts.numLayers, opts.P, opts.bias);
+			writeFile(opts.output + ".json", genome);
+			std::cout << "wrote " << opts.output << ".json\n";
+			writeCanvas(opts);
+		}else if(opts.command == "draw"){
+			drawFlower(genome, opts.radius, opts.numLayers, opts.P, opts.bias);
+			writeCanvas(opts);
+		}else if(opts.command == "petals"){
+			drawPetals(genome, opts.radius, opts.numLayers, opts.P, opts.bias);
+			writeCanvas(opts);
+		}else if(opts.command == "layer"){
+			drawPetalLayer(genome, opts.radius, opts.numLayers, opts.P, opts.bias, opts.layer);
+			writeCanvas(opts);
+		}else if(opts.command == "3d"){
+			auto gltf = make3DFlower(genome, opts.radius, opts.numLayers, opts.P, opts.bias, opts.flowerId, opts.flowerParams);
+			writeFile(opts.output + ".gltf", gltf);
+			std::cout << "wrote " << opts.output << ".gltf\n";
+		}else if(opts.command == "stats"){
+			std::cout << getFlowerStats(genome, opts.humidity, opts.temperature, opts.altitude, opts.terrainType) << "\n";
+		}else if(opts.command == "convert"){
+			if(isBinary){
+				writeFile(opts.output + ".json", genome);
+				std::cout << "wrote " << opts.output << ".json\n";
+			}else{
+				JsonBox::Value v;
+				v.loadFromString(genome);
+				writeFile(opts.output + ".feb", fe::binary::encode(v));
+				std::cout << "wrote " << opts.output << ".feb\n";
+			}
+		}else{
+			throw std::invalid_argument("unknown command " + opts.command);
+		}
+		if(opts.profile){
+			std::cerr << getProfile() << "\n";
+		}
+		if(!opts.traceFile.empty()){
+			writeFile(opts.traceFile, getTrace());
+			std::cout << "wrote " << opts.traceFile << "\n";
+		}
+	}catch(const std::exception& e){
+		std::cerr << "error: " << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,241 @@
+/*!
+ * @license Apache 2.0
+ * @cristianglezm/flower-evolver-wasm
+ * Copyright 2023-2025 Cristian Gonzalez <cristian.glez.m@gmail.com>
+ */
+
+/**
+ * @brief end-to-end throughput benchmark for the embind exports under node.
+ * @details it loads the ES6 build (FE_EXPORT=TRUE) with a stub canvas so copyToCanvas
+ *          runs as in the browser (new ImageData over a copy of the wasm memory / putImageData) and calls every export
+ *          in a loop, it prints json with throughput, latency percentiles and heap high-water mark.
+ * @code
+ *  node tools/wasm-bench/bench.mjs --module build/public/FlowerEvolver.js --iterations 50
+ * @endcode
+ */
+import fs from 'node:fs';
+import os from 'node:os';
+import path from 'node:path';
+import { performance } from 'node:perf_hooks';
+import { pathToFileURL } from 'node:url';
+
+const usage = `usage: node bench.mjs [options]
+
+options:
+  --module <path>       FlowerEvolver.js or .mjs ES6 build (default: dist/public/FlowerEvolver.mjs)
+  --iterations <int>    timed calls per export (default: 20)
+  --warmup <int>        untimed calls per export (default: 3)
+  --radius <int>        radius (default: 64)
+  --layers <int>        number of layers (default: 3)
+  --P <float>           P (default: 6.0)
+  --bias <float>        bias (default: 1.0)
+  --filter <string>     only run exports that contain <string>
+  --help                shows this help
+`;
+
+const parseArgs = (argv) => {
+    let opts = {
+        module: path.resolve('dist/public/FlowerEvolver.mjs'),
+        iterations: 20,
+        warmup: 3,
+        radius: 64,
+        layers: 3,
+        P: 6.0,
+        bias: 1.0,
+        filter: ''
+    };
+    for(let i=0;i<argv.length;++i){
+        let arg = argv[i];
+        if(arg === '--help' || arg === '-h'){
+            console.log(usage);
+            process.exit(0);
+        }
+        let value = argv[++i];
+        if(value === undefined){
+            throw Error(`missing value for ${arg}`);
+        }
+        switch(arg){
+            case '--module': opts.module = path.resolve(value); break;
+            case '--iterations': opts.iterations = Math.max(1, parseInt(value)); break;
+            case '--warmup': opts.warmup = Math.max(0, parseInt(value)); break;
+            case '--radius': opts.radius = parseInt(value); break;
+            case '--layers': opts.layers = parseInt(value); break;
+            case '--P': opts.P = parseFloat(value); break;
+            case '--bias': opts.bias = parseFloat(value); break;
+            case '--filter': opts.filter = value; break;
+            default: throw Error(`unknown argument ${arg}`);
+        }
+    }
+    return opts;
+};
+/**
+ * @brief ImageData, node doesn't have it.
+ */
+class StubImageData{
+    constructor(data, width, height){
+        this.data = data;
+        this.width = width;
+        this.height = height;
+    }
+};
+/**
+ * @brief minimal OffscreenCanvas / 2d context, enough for copyToCanvas.
+ */
+class StubContext{
+    constructor(canvas){
+        this.canvas = canvas;
+        this.bytesCopied = 0;
+    }
+    getImageData(x, y, w, h){
+        return { width: w, height: h, data: new Uint8ClampedArray(w * h * 4) };
+    }
+    putImageData(imageData, x, y){
+        this.bytesCopied += imageData.data.length;
+    }
+};
+class StubCanvas{
+    constructor(width = 128, height = 192){
+        this.width = width;
+        this.height = height;
+        this.context = new StubContext(this);
+    }
+    getContext(type, options){
+        return this.context;
+    }
+};
+/**
+ * @brief installs the stub canvas as document.getElementById("canvas") and self.canvas.
+ */
+const installCanvas = () => {
+    let canvas = new StubCanvas();
+    globalThis.OffscreenCanvas = StubCanvas;
+    globalThis.ImageData = globalThis.ImageData ?? StubImageData;
+    globalThis.self = globalThis.self ?? globalThis;
+    globalThis.self.canvas = canvas;
+    globalThis.document = {
+        getElementById: (id) => id === 'canvas' ? canvas : null,
+        createElement: () => new StubCanvas(),
+        body: { appendChild: () => {} }
+    };
+    return canvas;
+};
+/**
+ * @brief imports the ES6 module, node needs the .mjs extension to load it as a module.
+ */
+const loadModule = async (modulePath) => {
+    if(!fs.existsSync(modulePath)){
+        throw Error(`${modulePath} not found, build it with -DFE_EXPORT=TRUE`);
+    }
+    let target = modulePath;
+    if(path.extname(modulePath) !== '.mjs'){
+        let dir = fs.mkdtempSync(path.join(os.tmpdir(), 'fe-bench-'));
+        target = path.join(dir, 'FlowerEvolver.mjs');
+        fs.copyFileSync(modulePath, target);
+    }
+    let factory = (await import(pathToFileURL(target).href)).default;
+    return await factory();
+};
+
+const percentile = (sorted, p) => {
+    if(sorted.length === 0){
+        return 0;
+    }
+    let idx = Math.min(sorted.length - 1, Math.ceil((p / 100) * sorted.length) - 1);
+    return sorted[Math.max(0, idx)];
+};
+
+const heapStats = (fe) => JSON.parse(fe.getHeapStats());
+
+const errorMessage = (fe, e) => {
+    if(typeof e === 'number'){
+        return fe.getExceptionMessage(e);
+    }
+    if(e && typeof e.excPtr === 'number'){
+        return fe.getExceptionMessage(e.excPtr);
+    }
+    return String(e);
+};
+/**
+ * @brief calls fn warmup + iterations times and gets the timings in ms.
+ */
+const run = (fe, canvas, name, fn, opts) => {
+    for(let i=0;i<opts.warmup;++i){
+        fn();
+    }
+    canvas.context.bytesCopied = 0;
+    let samples = [];
+    let start = performance.now();
+    for(let i=0;i<opts.iterations;++i){
+        let t0 = performance.now();
+        fn();
+        samples.push(performance.now() - t0);
+    }
+    let total = performance.now() - start;
+    samples.sort((a, b) => a - b);
+    let heap = heapStats(fe);
+    return {
+        export: name,
+        iterations: opts.iterations,
+        opsPerSec: (opts.iterations * 1000) / total,
+        mean_ms: samples.reduce((a, b) => a + b, 0) / samples.length,
+        min_ms: samples[0],
+        p50_ms: percentile(samples, 50),
+        p90_ms: percentile(samples, 90),
+        p99_ms: percentile(samples, 99),
+        max_ms: samples[samples.length - 1],
+        canvasBytesPerCall: canvas.context.bytesCopied / opts.iterations,
+        heapInUse: heap.inUse,
+        heapMaxFootprint: heap.maxFootprint
+    };
+};
+
+const main = async () => {
+    let opts = parseArgs(process.argv.slice(2));
+    let canvas = installCanvas();
+    canvas.width = opts.radius * 2;
+    canvas.height = opts.radius * 3;
+    let fe = await loadModule(opts.module);
+    let { radius, layers, P, bias } = opts;
+    let genome = fe.makeFlower(radius, layers, P, bias);
+    let genome2 = fe.makeFlower(radius, layers, P, bias);
+    const exports = [
+        ['makeFlower', () => fe.makeFlower(radius, layers, P, bias)],
+        ['makePetals', () => fe.makePetals(radius, layers, P, bias)],
+        ['makePetalLayer', () => fe.makePetalLayer(radius, layers, P, bias, layers)],
+        ['makeStem', () => fe.makeStem(radius, layers, P, bias)],
+        ['drawFlower', () => fe.drawFlower(genome, radius, layers, P, bias)],
+        ['drawPetals', () => fe.drawPetals(genome, radius, layers, P, bias)],
+        ['drawPetalLayer', () => fe.drawPetalLayer(genome, radius, layers, P, bias, layers)],
+        ['reproduce', () => fe.reproduce(genome, genome2, radius, layers, P, bias)],
+        ['mutate', () => fe.mutate(genome, radius, layers, P, bias, 0.2, 0.3, 0.2, 0.6, 0.35, 0.3, 0.4)],
+        ['make3DFlower', () => fe.make3DFlower(genome, radius, layers, P, bias, 'bench', '')],
+        ['getFlowerStats', () => fe.getFlowerStats(genome, 0.5, 25, 0, 0)]
+    ];
+    let results = [];
+    for(let [name, fn] of exports){
+        if(opts.filter && !name.includes(opts.filter)){
+            continue;
+        }
+        try{
+            let result = run(fe, canvas, name, fn, opts);
+            console.error(`${name}: ${result.opsPerSec.toFixed(2)} ops/s p50=${result.p50_ms.toFixed(2)}ms p99=${result.p99_ms.toFixed(2)}ms`);
+            results.push(result);
+        }catch(e){
+            results.push({ export: name, error: errorMessage(fe, e) });
+        }
+    }
+    let heap = heapStats(fe);
+    console.log(JSON.stringify({
+        benchmark: 'FlowerEvolver-wasm',
+        node: process.version,
+        params: { radius, numLayers: layers, P, bias },
+        heap,
+        results
+    }, null, 2));
+    process.exit(0);
+};
+
+main().catch((e) => {
+    console.error(e.message ?? e);
+    process.exit(1);
+});